@@ -0,0 +1,119 @@
+#pragma once
+
+#include <vector>
+
+#include "BandedCholesky.hpp"
+#include "Datastructures.hpp"
+#include "Grid.hpp"
+#include "PoissonOperator.hpp"
+
+/**
+ * @brief Sparse matrix in compressed sparse row (CSR) format
+ *
+ */
+struct CSRMatrix {
+    int rows{0};
+    int cols{0};
+    /// Position of the first entry of every row in col and value, rows + 1 entries
+    std::vector<int> row_start{0};
+    std::vector<int> col;
+    std::vector<double> value;
+
+    /// Number of stored entries
+    int nonzeros() const { return value.size(); }
+
+    /**
+     * @brief Matrix-vector product y = A x
+     *
+     * @param[in] x
+     * @param[out] y
+     */
+    void multiply(const std::vector<double> &x, std::vector<double> &y) const;
+};
+
+/**
+ * @brief Smoothed aggregation algebraic multigrid preconditioner for the
+ * pressure Poisson equation
+ *
+ * The operator of PoissonOperator is assembled as CSR matrix over the coupled
+ * fluid cells of the subdomain. Coarse levels follow from the matrix only:
+ * strongly coupled cells are grouped into aggregates, the piecewise constant
+ * prolongation of the aggregates is smoothed by one damped Jacobi step and the
+ * coarse operator is the Galerkin product R A P with R = P^T. Thin channels and
+ * walls of the geometry thus stay separated on all levels without any
+ * geometric rule. The hierarchy is built once, since the geometry does not
+ * change, and the coarsest level is factorized with banded Cholesky.
+ *
+ * Applying the preconditioner is one V-cycle with a forward Gauss-Seidel sweep
+ * before and a backward sweep after the coarse grid correction, so it is
+ * symmetric and can be used by PCG. With several processes every process
+ * builds the hierarchy of its subdomain without the couplings to the halo,
+ * the processes are coupled by the outer Krylov iteration.
+ *
+ * The number of levels, the operator complexity (the entries of all levels
+ * relative to the fine matrix) and the setup time are printed at startup.
+ *
+ */
+class AlgebraicMultigrid {
+  public:
+    AlgebraicMultigrid() = default;
+
+    /**
+     * @brief Constructor of the preconditioner, assembles the matrix and
+     * builds the hierarchy
+     *
+     * @param[in] operator of the pressure equation
+     * @param[in] grid with the fluid cells of the subdomain
+     */
+    AlgebraicMultigrid(const PoissonOperator &op, const Grid &grid);
+
+    /**
+     * @brief Apply the preconditioner, z = M^-1 r
+     *
+     * @param[in] residual, zero outside the coupled fluid cells
+     * @param[out] preconditioned residual, zero in the ghost layer
+     */
+    void apply(const Matrix<double> &r, Matrix<double> &z);
+
+  private:
+    /// Operator, transfer operators and vectors of one level, level 0 is the fine matrix
+    struct Level {
+        CSRMatrix A;
+        /// Prolongation from the next coarser level and its transpose
+        CSRMatrix P;
+        CSRMatrix R;
+        std::vector<double> inv_diag;
+        /// Solution, right hand side and residual
+        std::vector<double> x;
+        std::vector<double> b;
+        std::vector<double> r;
+    };
+
+    /**
+     * @brief Build the next coarser level by smoothed aggregation
+     *
+     * @param[in] index of the fine level
+     * @return false if the matrix cannot be coarsened further
+     */
+    bool coarsen(int l);
+
+    /**
+     * @brief V-cycle on a level from zero initial guess
+     *
+     * @param[in] index of the level
+     */
+    void cycle(int l);
+
+    /**
+     * @brief Gauss-Seidel sweep over the rows of a level
+     *
+     * @param[in] level
+     * @param[in] true for ascending, false for descending order of the rows
+     */
+    void sweep(Level &level, bool forward);
+
+    /// Storage index of the cell of every row of the fine matrix
+    std::vector<int> _cells;
+    std::vector<Level> _levels;
+    BandedCholesky _coarse;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Cholesky factorization A = L L^T of a symmetric positive
+ * (semi-)definite band matrix
+ *
+ * Only the lower band of A is stored, row by row, and the factor overwrites
+ * it. Factorization costs O(n b^2) and each solve O(n b) for n unknowns and
+ * half bandwidth b, so the unknowns should be numbered to keep b small.
+ *
+ * A singular component of A, e.g. a region with Neumann conditions only, has
+ * the constant in its kernel. pin_singular_components() pins one unknown of
+ * each such component explicitly. Otherwise a pivot that vanishes up to
+ * round-off is replaced by the diagonal entry of A (or by 1 for a zero row),
+ * which pins the last unknown of that component, so the factor solves the
+ * system up to a constant on that component.
+ *
+ */
+class BandedCholesky {
+  public:
+    BandedCholesky() = default;
+
+    /**
+     * @brief Constructor of a zero band matrix
+     *
+     * @param[in] number of unknowns
+     * @param[in] half bandwidth, the largest distance of an entry from the diagonal
+     */
+    BandedCholesky(int size, int bandwidth);
+
+    /**
+     * @brief Add a value to an entry of the lower band of A, before factorize()
+     *
+     * @param[in] row
+     * @param[in] column, at most row and at least row - bandwidth
+     * @param[in] value to add
+     */
+    void add(int row, int col, double value);
+
+    /**
+     * @brief Pin the singular components of A explicitly, after all add() and
+     * before factorize()
+     *
+     * A component of the graph of A whose rows all sum to zero gets an identity
+     * row and column for its first unknown. solve() then removes the mean of
+     * the right hand side over the component and sets the pinned unknown to
+     * zero, which gives a solution of the singular system.
+     *
+     * @return number of pinned unknowns
+     */
+    int pin_singular_components();
+
+    /**
+     * @brief Factorize A in place
+     *
+     * @return number of pinned unknowns, i.e. of singular components
+     */
+    int factorize();
+
+    /**
+     * @brief Solve A x = b with the factor
+     *
+     * @param[in,out] right hand side b, replaced by the solution x
+     */
+    void solve(std::vector<double> &x) const;
+
+    /// Number of unknowns
+    int size() const { return _size; }
+    /// Half bandwidth
+    int bandwidth() const { return _bandwidth; }
+    /// Memory of the band in bytes
+    std::size_t memory() const { return _band.size() * sizeof(double); }
+
+  private:
+    /// Entry (row, col) of the lower band
+    double &entry(int row, int col) {
+        return _band[static_cast<std::size_t>(row) * (_bandwidth + 1) + col - row + _bandwidth];
+    }
+    double entry(int row, int col) const {
+        return _band[static_cast<std::size_t>(row) * (_bandwidth + 1) + col - row + _bandwidth];
+    }
+
+    int _size{0};
+    int _bandwidth{0};
+    std::vector<double> _band;
+    /// Unknowns of the singular components, the first of each is pinned
+    std::vector<std::vector<int>> _components;
+};
@@ -7,10 +7,86 @@
 #include <iostream>
 #include <map>
 
+/**
+ * @brief Boundary condition of one field compiled to a list of assignments
+ *
+ * Every entry sets target[index] = weight0 * source[source0] + weight1 * source[source1] + constant
+ * for storage indices of the fields. The entries are applied in order, so an
+ * entry sees the values set by the earlier ones, as the per-cell code did.
+ *
+ * Entries with an index BoundaryTable::outside are dropped, see Boundary::at.
+ * Any other index outside the fields is a bug in the construction of the
+ * table. Such entries are dropped too, or throw std::out_of_range with
+ * FLUIDCHEN_BOUNDS_CHECK.
+ *
+ */
+class BoundaryTable {
+  public:
+    /// Index of a value beyond the ghost layer of the fields
+    static constexpr int outside = -1;
+
+    /**
+     * @brief Append an assignment from one source value
+     *
+     * @param[in] storage index of the target value
+     * @param[in] storage index of the source value
+     * @param[in] weight of the source value
+     * @param[in] constant
+     */
+    void add(int target, int source, double weight, double constant = 0.0);
+
+    /**
+     * @brief Append an assignment from two source values
+     *
+     * @param[in] storage index of the target value
+     * @param[in] storage index of the first source value
+     * @param[in] weight of the first source value
+     * @param[in] storage index of the second source value
+     * @param[in] weight of the second source value
+     */
+    void add(int target, int source0, double weight0, int source1, double weight1);
+
+    /**
+     * @brief Apply all assignments in order
+     *
+     * Instantiated for double and float matrices, the assignments are
+     * evaluated in double. With FLUIDCHEN_BOUNDS_CHECK the indices are
+     * checked against the sizes of the matrices.
+     *
+     * @param[in] field the source values are taken from, may be the target
+     * @param[in,out] field the values are assigned to
+     */
+    template <typename T> void apply(const Matrix<T> &source, Matrix<T> &target) const;
+
+    /**
+     * @brief Remove all assignments
+     *
+     * @param[in] number of stored elements of the fields the following assignments are for
+     */
+    void reset(int size);
+
+  private:
+    /// Whether an entry with this index is kept, throws for a bad index with FLUIDCHEN_BOUNDS_CHECK
+    bool keep(int index) const;
+
+    struct Entry {
+        int target;
+        int source[2];
+        double weight[2];
+        double constant;
+    };
+    std::vector<Entry> _entries;
+    int _size{0};
+};
+
 /**
  * @brief Abstract of boundary conditions.
  *
- * This class patches the physical values to the given field.
+ * This class patches the physical values to the given field. The derived
+ * classes translate their conditions for the cells and their borders once into
+ * a BoundaryTable per field, so applying a condition is a single pass over the
+ * table without any branches on the cell borders. The tables use the storage
+ * indices of the fields and are built on the first use.
  */
 class Boundary {
   public:
@@ -19,29 +95,68 @@ class Boundary {
      *
      * @param[in] Field to be applied
      */
-    virtual void applyVelocity(Fields &field) = 0;
+    void applyVelocity(Fields &field);
 
     /**
      * @brief Method to patch the pressure boundary conditions to the given field.
      *
      * @param[in] Field to be applied
      */
-    virtual void applyPressure(Fields &field) = 0;
+    void applyPressure(Fields &field);
 
     /**
      * @brief Method to patch the flux (F & G) boundary conditions to the given field.
      *
      * @param[in] Field to be applied
      */
-    virtual void applyFlux(Fields &field);
+    void applyFlux(Fields &field);
 
-    virtual void applyTemperature(Fields &field);
+    void applyTemperature(Fields &field);
 
     virtual ~Boundary() = default;
 
   protected:
-    Boundary(std::vector<Cell *> cells);
-    std::vector<Cell *> _cells;
+    Boundary(std::vector<Cell> cells);
+
+    /**
+     * @brief Build the tables of the conditions for the storage layout set by
+     * prepare, the default builds the flux table
+     */
+    virtual void build_tables();
+
+    /**
+     * @brief Storage index of cell (i, j) of the fields
+     *
+     * The conditions of ghost layer cells next to halo fluid cells can reach
+     * beyond the ghost layer, e.g. the corner conditions of a wall cell in the
+     * ghost row. These values are not stored, and the index is
+     * BoundaryTable::outside.
+     *
+     * @param[in] x index
+     * @param[in] y index
+     */
+    int at(int i, int j) const;
+
+    std::vector<Cell> _cells;
+    /// Conditions of the velocities, the pressure, the fluxes (from the velocities) and the temperature
+    BoundaryTable _u_table;
+    BoundaryTable _v_table;
+    BoundaryTable _p_table;
+    BoundaryTable _f_table;
+    BoundaryTable _g_table;
+    BoundaryTable _t_table;
+
+  private:
+    /**
+     * @brief Build the tables if they are not built for fields of this layout yet
+     *
+     * @param[in] field whose layout the tables are built for
+     */
+    template <typename T> void prepare(const Matrix<T> &field);
+
+    int _stride{-1};
+    int _num_cols{0};
+    int _num_rows{0};
 };
 
 /**
@@ -50,26 +165,26 @@ class Boundary {
  */
 class FixedWallBoundary : public Boundary {
   public:
-    FixedWallBoundary(std::vector<Cell *> cells);
-    FixedWallBoundary(std::vector<Cell *> cells, std::map<int, double> wall_temperature);
-    FixedWallBoundary(std::vector<Cell *> cells, double wall_temperature);
+    FixedWallBoundary(std::vector<Cell> cells);
+    FixedWallBoundary(std::vector<Cell> cells, double wall_temperature);
     virtual ~FixedWallBoundary() = default;
-    virtual void applyVelocity(Fields &field);
-    virtual void applyPressure(Fields &field);
-    void applyTemperature(Fields &field);
 
-  private:
-        double _wall_temperature;
+  protected:
+    void build_tables() override;
 
+  private:
+    /// Wall temperature, -1 for an adiabatic wall
+    double _wall_temperature{-1};
 };
 
 class InnerObstacle : public Boundary {
   public:
-    InnerObstacle(std::vector<Cell *> cells);
+    InnerObstacle(std::vector<Cell> cells);
     virtual ~InnerObstacle() = default;
-    virtual void applyVelocity(Fields &field); // do nothing
-    virtual void applyPressure(Fields &field); // do nothing
-    virtual void applyFlux(Fields &field); // do nothing
+
+  protected:
+    /// Zero velocities, no pressure and flux conditions
+    void build_tables() override;
 };
 
 /**
@@ -79,12 +194,13 @@ class InnerObstacle : public Boundary {
  */
 class MovingWallBoundary : public Boundary {
   public:
-    MovingWallBoundary(std::vector<Cell *> cells, double wall_velocity);
-    MovingWallBoundary(std::vector<Cell *> cells, std::map<int, double> wall_velocity,
+    MovingWallBoundary(std::vector<Cell> cells, double wall_velocity);
+    MovingWallBoundary(std::vector<Cell> cells, std::map<int, double> wall_velocity,
                        std::map<int, double> wall_temperature);
     virtual ~MovingWallBoundary() = default;
-    virtual void applyVelocity(Fields &field);
-    virtual void applyPressure(Fields &field);
+
+  protected:
+    void build_tables() override;
 
   private:
     std::map<int, double> _wall_velocity;
@@ -93,12 +209,13 @@ class MovingWallBoundary : public Boundary {
 
 class FixedVelocityBoundary : public Boundary {
   public:
-    FixedVelocityBoundary(std::vector<Cell *> cells, double inflow_u_velocity, double inflow_v_velocity);
-    FixedVelocityBoundary(std::vector<Cell *> cells, std::map<int, double> inflow_u_velocity, std::map<int, double> inflow_v_velocity,
-                       std::map<int, double> wall_temperature);
+    FixedVelocityBoundary(std::vector<Cell> cells, double inflow_u_velocity, double inflow_v_velocity);
+    FixedVelocityBoundary(std::vector<Cell> cells, std::map<int, double> inflow_u_velocity,
+                          std::map<int, double> inflow_v_velocity, std::map<int, double> wall_temperature);
     virtual ~FixedVelocityBoundary() = default;
-    virtual void applyVelocity(Fields &field);
-    virtual void applyPressure(Fields &field);
+
+  protected:
+    void build_tables() override;
 
   private:
     std::map<int, double> _inflow_u_velocity;
@@ -108,14 +225,13 @@ class FixedVelocityBoundary : public Boundary {
 
 class ZeroGradientBoundary : public Boundary {
   public:
-    ZeroGradientBoundary(std::vector<Cell *> cells);
-    ZeroGradientBoundary(std::vector<Cell *> cells, std::map<int, double> wall_temperature);
+    ZeroGradientBoundary(std::vector<Cell> cells);
+    ZeroGradientBoundary(std::vector<Cell> cells, std::map<int, double> wall_temperature);
     virtual ~ZeroGradientBoundary() = default;
-    virtual void applyVelocity(Fields &field);
-    virtual void applyPressure(Fields &field);
 
+  protected:
+    void build_tables() override;
 
   private:
     std::map<int, double> _wall_temperature;
 };
-
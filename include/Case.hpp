@@ -6,11 +6,19 @@
 #include <iostream>
 
 #include "Boundary.hpp"
+#include "Chebyshev.hpp"
+#include "ConjugateGradient.hpp"
+#include "DirectSolver.hpp"
 #include "Discretization.hpp"
 #include "Domain.hpp"
+#include "FastPoissonSolver.hpp"
 #include "Fields.hpp"
 #include "Grid.hpp"
+#include "LineSOR.hpp"
+#include "MixedPrecision.hpp"
+#include "Multigrid.hpp"
 #include "PressureSolver.hpp"
+#include "TiledSOR.hpp"
 #include "Communication.hpp"
 
 
@@ -69,6 +77,9 @@ class Case {
     /// Maximum number of iterations for the solver
     int _max_iter;
 
+    /// Order of the extrapolation of the initial pressure guess in time, 0 to start from the last pressure
+    int _p_extrapolation{0};
+
     /**
      * @brief Creating file names from given input data file
      *
@@ -1,13 +1,14 @@
 #pragma once
 
-#include <array>
-#include <vector>
+#include <cstdint>
 
 #include "Enums.hpp"
 
 /**
- * @brief Main element of the grid that holds neighboring and type
- * information.
+ * @brief Type, wall id and borders of a cell of the grid
+ *
+ * Cells are small values that the grid creates from its flag arrays, the
+ * neighbours of a cell follow from its indices.
  *
  */
 class Cell {
@@ -30,39 +31,10 @@ class Cell {
      * @param[in] y index of the cell
      * @param[in] type of the cell
      * @param[in] id of the cell, only for walls
+     * @param[in] borders to fluid cells, bit 1 << border_position for every border
      */
-    Cell(int i, int j, cell_type type, int id);
-
-    /**
-     * @brief Neighbour getter for given border position
-     *
-     * @param[in] border position
-     * @param[out] pointer to the neighboring cell
-     */
-    const Cell *neighbour(border_position position) const;
-    /**
-     * @brief Neighbour setter for given border position
-     *
-     * @param[in] border position
-     */
-    void set_neighbour(Cell *cell, border_position position);
+    Cell(int i, int j, cell_type type, int id, std::uint8_t borders = 0);
 
-    /**
-     * @brief Access to the borders where fluid cells exist
-     *
-     * @param[out] vector of borders where fluid cells exist
-     */
-    const std::vector<border_position> &borders() const;
-
-    /**
-     * @brief Append new border to the cell
-     *
-     * Sets the corresponding border to true and adds the border
-     * to the container
-     *
-     * @param[in] border position where fluid cell exists
-     */
-    void add_border(border_position border);
     /**
      * @brief Check whether the given position is a border to a
      * fluid cell or not
@@ -81,6 +53,11 @@ class Cell {
     /// Getter of cell id
     int wall_id() const;
 
+    /// Bit of the given border in the border mask
+    static constexpr std::uint8_t border_bit(border_position position) {
+        return static_cast<std::uint8_t>(1u << static_cast<int>(position));
+    }
+
   private:
     /// x index
     int _i{0};
@@ -89,12 +66,7 @@ class Cell {
     /// Cell type
     cell_type _type{cell_type::DEFAULT};
     /// Cell id (only necessary for walls)
-    int _id{0};
-
-    /// Vector of bools that holds border conditions. TOP-BOTTOM-LEFT-RIGHT
-    std::array<bool, 4> _border{false, false, false, false};
-    /// Vector of border positions that holds existing borders
-    std::vector<border_position> _borders;
-    /// Pointers to neighbours. // TOP -  BOTTOM - LEFT - RIGHT
-    std::array<Cell *, 4> _neighbours;
+    std::uint8_t _id{0};
+    /// Borders to fluid cells, TOP - BOTTOM - LEFT - RIGHT from the lowest bit
+    std::uint8_t _borders{0};
 };
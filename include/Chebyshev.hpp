@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ConjugateGradient.hpp"
+
+/**
+ * @brief Chebyshev iteration with block Jacobi preconditioning for the
+ * pressure Poisson equation
+ *
+ * The residual of the pressure is multiplied by the Chebyshev polynomial that
+ * is smallest on an interval [lambda_min, lambda_max] holding the eigenvalues
+ * of M^-1 A. M is the symmetric Gauss-Seidel preconditioner of PCG, which
+ * sweeps each subdomain without its halo, i.e. Jacobi between the processes.
+ * Contrary to CG the coefficients of the polynomial only depend on the
+ * interval, so an iteration is one halo exchange, one application of the
+ * operator and of M and two vector updates, without global reductions. The RMS
+ * of the residual is only reduced at the end of each batch of iterations, see
+ * PressureSolver::set_residual_interval.
+ *
+ * The interval is estimated in the constructor from a few dozen steps of the
+ * Lanczos process on the operator of the grid, i.e. preconditioned CG on a
+ * random right hand side, and printed. The largest Ritz value is enlarged by a
+ * safety margin, since eigenvalues above the interval make the iteration
+ * diverge. The smallest Ritz value converges slowest and is reduced by a
+ * margin. Eigenvalues below the interval only converge slower, so when a solve
+ * falls well behind the predicted reduction the estimate is repeated with twice
+ * the steps before the next timestep, until the smallest Ritz value settles or
+ * the steps reach a limit of 320.
+ *
+ */
+class Chebyshev : public PCG {
+  public:
+    Chebyshev() = default;
+
+    /**
+     * @brief Constructor of Chebyshev solver, estimates the eigenvalue bounds
+     *
+     * @param[in] grid to build the operator from
+     */
+    Chebyshev(const Grid &grid);
+
+    virtual ~Chebyshev() = default;
+
+    /**
+     * @brief Perform one batch of Chebyshev iterations
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Iterate until the global residual at the end of a batch is below
+     * the tolerance or the maximum number of iterations is reached
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual
+     * @param[in] maximum number of iterations
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+    /**
+     * @brief Current lower eigenvalue bound and Lanczos steps of its estimate
+     *
+     */
+    virtual std::string statistics() const;
+
+  private:
+    /**
+     * @brief Run preconditioned CG on a random right hand side and
+     * compute the extreme eigenvalues of its Lanczos matrix
+     *
+     * Overwrites the residual and search direction of the iteration.
+     *
+     * @param[in] maximum number of Lanczos steps
+     */
+    void estimate_bounds(int steps);
+
+    /**
+     * @brief Residual and first step of the iteration from the current pressure
+     *
+     * @param[in] field to be used
+     * @return RMS of the residual
+     */
+    double restart(Fields &field);
+
+    /**
+     * @brief Perform Chebyshev iterations from the current residual
+     *
+     * @param[in] field to be used
+     * @param[in] number of iterations
+     * @return sum of the squared residuals over the coupled cells of this process
+     */
+    double iterate(Fields &field, int iterations);
+
+    double _lambda_min{0.0};
+    double _lambda_max{2.0};
+    /// Maximum number of steps of the last estimate, and whether its smallest Ritz value settled
+    int _lanczos_steps{0};
+    bool _settled{false};
+    /// Whether the last timestep fell behind the bounds, estimated again before the next one
+    bool _refine{false};
+    /// Ratio of the current and the previous Chebyshev coefficient
+    double _rho{0.0};
+};
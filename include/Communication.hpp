@@ -5,6 +5,7 @@
 #include "Fields.hpp"
 #include "Datastructures.hpp"
 #include <array>
+#include <vector>
 
 // stores the rank of the current process in the custom communicator
 inline int my_rank_global;
@@ -74,10 +75,39 @@ class Communication{
         /**
         * @brief communicate a matrix
         *
+        * Instantiated for double and float matrices.
+        *
         * @param[in] matrix
         *
         */ 
-        static void communicate(Matrix<double> &matrix);
+        template <typename T> static void communicate(Matrix<T> &matrix);
+
+        /**
+        * @brief communicate only the halo values of one checkerboard color
+        *
+        * Cell (i, j) has color (i + j + parity) % 2. Used by the red-black
+        * solvers, which only changed the values of one color since the last
+        * exchange.
+        *
+        * @param[in] matrix
+        * @param[in] color to exchange, 0 or 1
+        * @param[in] parity of the local index origin in the global grid
+        *
+        */
+        template <typename T> static void communicate_color(Matrix<T> &matrix, int color, int parity);
+
+        /**
+        * @brief add the halo values of a matrix to the cells they are copies of
+        *
+        * Reverse of communicate: the values in the ghost layer at process interfaces
+        * are sent to the neighbour and added to its outermost inner cells, e.g. to
+        * sum up contributions of overlapping subdomains. The corners of the ghost
+        * layer are not sent.
+        *
+        * @param[in] matrix
+        *
+        */
+        static void accumulate(Matrix<double> &matrix);
 
         /**
         * @brief find minimum value across all processes
@@ -87,6 +117,14 @@ class Communication{
         */ 
         static double reduce_min(double value);
 
+        /**
+        * @brief find maximum value across all processes
+        *
+        * @param[in] value
+        *
+        */ 
+        static double reduce_max(double value);
+
         /**
         * @brief find total sum across all processes
         *
@@ -95,6 +133,49 @@ class Communication{
         */ 
         static double reduce_sum(double residual);
 
+        /**
+        * @brief find total sums of several values across all processes in one reduction
+        *
+        * @param[in,out] values, replaced by their sums
+        *
+        */
+        static void reduce_sum(std::vector<double> &values);
+
+        /**
+        * @brief start a non-blocking sum of several values across all processes
+        *
+        * @param[in,out] values, replaced by their sums once the reduction is completed by wait()
+        *
+        */
+        static MPI_Request ireduce_sum(std::vector<double> &values);
+
+        /**
+        * @brief gather one value of every process, in rank order
+        *
+        * @param[in] value of this process
+        *
+        */
+        static std::vector<int> all_gather(int value);
+
+        /**
+        * @brief concatenate the values of all processes, in rank order
+        *
+        * @param[in] values of this process
+        * @param[in] number of values of every process
+        * @param[out] values of all processes
+        *
+        */
+        static void all_gather(const std::vector<double> &values, const std::vector<int> &counts,
+                               std::vector<double> &result);
+
+        /**
+        * @brief wait for the completion of a non-blocking reduction
+        *
+        * @param[in] request of the reduction
+        *
+        */
+        static void wait(MPI_Request &request);
+
 
         ~Communication() = default;
 
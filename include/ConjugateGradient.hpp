@@ -0,0 +1,159 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "AlgebraicMultigrid.hpp"
+#include "FastPoissonSolver.hpp"
+#include "PoissonOperator.hpp"
+#include "PressureSolver.hpp"
+#include "Schwarz.hpp"
+
+/**
+ * @brief Preconditioned Conjugate Gradient method for solution of pressure
+ * Poisson equation
+ *
+ * Solves A p = -RS with the matrix-free PoissonOperator on the fluid cells. Each
+ * iteration needs one halo exchange for the operator application and two global
+ * reductions for the dot products. Neither needs a relaxation factor.
+ *
+ * Available preconditioners:
+ * - Jacobi: scaling with the inverse diagonal
+ * - SGS: one symmetric Gauss-Seidel sweep on the subdomain, the coupling to
+ *   the neighbouring subdomains is neglected (block Jacobi over the processes)
+ * - Schwarz: two-level additive Schwarz with exact solves on the overlapping
+ *   subdomains and a coarse correction, see AdditiveSchwarz
+ * - AMG: one smoothed aggregation multigrid V-cycle per subdomain, see
+ *   AlgebraicMultigrid
+ * - FastPoisson: exact solve of the Poisson equation with Neumann walls on the
+ *   bounding box of the whole domain with cosine transforms, see
+ *   FastPoissonSolver. It differs from the operator only at obstacles and
+ *   outflows, so the iterations hardly grow with the resolution.
+ *
+ */
+class PCG : public PressureSolver {
+  public:
+    /// Preconditioners of the conjugate gradient method
+    enum class Preconditioner { Jacobi, SGS, Schwarz, AMG, FastPoisson };
+
+    PCG() = default;
+
+    /**
+     * @brief Constructor of PCG solver
+     *
+     * @param[in] grid to build the operator from
+     * @param[in] name of the preconditioner, "Jacobi", "SGS", "Schwarz", "AMG" or "FastPoisson"
+     */
+    PCG(const Grid &grid, const std::string &preconditioner);
+
+    virtual ~PCG() = default;
+
+    /**
+     * @brief Perform one preconditioned steepest descent step, i.e. one
+     * restarted CG iteration
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Iterate CG until the global residual is below the tolerance or
+     * the maximum number of iterations is reached
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual
+     * @param[in] maximum number of iterations
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+  protected:
+    /// Residual r = -RS - A p of the current pressure, projected to zero mean if the operator is singular
+    void initial_residual(Fields &field);
+    /// Write the ghost values of the pressure after the iterations
+    void finish(Fields &field, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+    /// z = M^-1 r
+    void precondition(const Matrix<double> &r, Matrix<double> &z);
+
+    PoissonOperator _op;
+    Preconditioner _preconditioner{Preconditioner::SGS};
+    std::unique_ptr<AdditiveSchwarz> _schwarz;
+    std::unique_ptr<AlgebraicMultigrid> _amg;
+    std::unique_ptr<FastPoissonSolver> _fast_poisson;
+    /// Residual, preconditioned residual, search direction and its image
+    Matrix<double> _r;
+    Matrix<double> _z;
+    Matrix<double> _d;
+    Matrix<double> _q;
+
+  private:
+    /// Initial residual and search direction of the current pressure, returns the RMS of the residual
+    double start(Fields &field);
+    /**
+     * @brief One CG iteration
+     *
+     * @param[in,out] field whose pressure is updated
+     * @param[out] RMS of the residual
+     * @param[out] false on a breakdown (d^T A d <= 0), the pressure is then unchanged
+     */
+    bool iterate(Fields &field, double &residual);
+
+    /// r^T z of the current iteration
+    double _rz{0.0};
+};
+
+/**
+ * @brief Pipelined preconditioned Conjugate Gradient method (Ghysels and Vanroose)
+ *
+ * Mathematically equivalent to PCG, but the recurrences are rearranged so that
+ * all dot products of an iteration are combined into one non-blocking global
+ * reduction. The reduction runs while the preconditioner, the halo exchange and
+ * the operator application of the next iteration are computed, hiding the
+ * latency of the reduction at large process counts. This costs four additional
+ * vectors and one more preconditioner application per iteration.
+ *
+ */
+class PipelinedCG : public PCG {
+  public:
+    PipelinedCG() = default;
+
+    /**
+     * @brief Constructor of pipelined CG solver
+     *
+     * @param[in] grid to build the operator from
+     * @param[in] name of the preconditioner, "Jacobi", "SGS", "Schwarz", "AMG" or "FastPoisson"
+     */
+    PipelinedCG(const Grid &grid, const std::string &preconditioner);
+
+    virtual ~PipelinedCG() = default;
+
+    /**
+     * @brief Iterate pipelined CG until the global residual is below the
+     * tolerance or the maximum number of iterations is reached
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual
+     * @param[in] maximum number of iterations
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+  private:
+    /// Preconditioned residual u = M^-1 r and its images w = A u, m = M^-1 w, n = A m
+    Matrix<double> _u;
+    Matrix<double> _w;
+    Matrix<double> _m;
+    Matrix<double> _n;
+    /// Recurrences of the search direction _d: s = A d, mq = M^-1 s, aq = A mq
+    Matrix<double> _s;
+    Matrix<double> _mq;
+    Matrix<double> _aq;
+};
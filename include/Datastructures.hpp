@@ -1,16 +1,88 @@
 #pragma once
 
-#include <vector>
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Memory.hpp"
+
+/**
+ * @brief Floating point type of the velocities, fluxes and temperature
+ *
+ * float with the CMake option FLUIDCHEN_SINGLE_PRECISION, double otherwise.
+ * The pressure and the right hand side of the pressure equation are always
+ * double, the pressure solvers reach tolerances below the accuracy of float.
+ *
+ */
+#ifdef FLUIDCHEN_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
 
 /**
- * @brief General 2D data structure around std::vector, in column
- * major format.
+ * @brief Allocator for std::vector with storage aligned to the given number of bytes
+ *
+ * The storage comes from Memory, large allocations are backed by huge pages.
+ * Elements are default-initialized, so resize() does not write to the pages
+ * and the owner decides which thread touches them first.
+ *
+ */
+template <typename T, std::size_t Alignment> struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U> struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment> &) {}
+
+    T *allocate(std::size_t n) { return static_cast<T *>(Memory::allocate(n * sizeof(T), Alignment)); }
+    void deallocate(T *p, std::size_t n) { Memory::deallocate(p, n * sizeof(T), Alignment); }
+
+    template <typename U> void construct(U *p) { ::new (static_cast<void *>(p)) U; }
+    template <typename U, typename... Args> void construct(U *p, Args &&...args) {
+        ::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment> &) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment> &) const { return false; }
+};
+
+/**
+ * @brief General 2D data structure in row-major format
+ *
+ * Element (i, j) is stored at index stride() * j + i, i.e. the elements of a
+ * row (constant j, the y index) are contiguous. Rows are padded to a multiple
+ * of 16 elements and the storage is aligned to 64 bytes, so every row starts on
+ * a cache line for float and double, and matrices of the same size share the
+ * same storage indices regardless of the element type. The padding is zero and
+ * not accessible through operator().
+ *
+ * The constructors write the rows 1 to num_rows() - 2 in a static OpenMP
+ * loop, the partition of the compute loops over the rows, so the pages of a
+ * thread's rows are placed on its NUMA node by the first touch.
+ *
+ * operator() does not check the indices, unless the code is compiled with
+ * FLUIDCHEN_BOUNDS_CHECK (CMake option of the same name). Kernels can work on
+ * the raw storage through data() or row() with stride(); these accesses are
+ * never checked, only operator() and the boundary tables are.
  *
  */
 template <typename T> class Matrix {
 
   public:
+    /// Alignment of the storage in bytes
+    static constexpr std::size_t alignment = 64;
+    /// The row length is padded to a multiple of this number of elements
+    static constexpr int row_padding = 16;
+
     Matrix<T>() = default;
 
     /**
@@ -21,21 +93,20 @@ template <typename T> class Matrix {
      * @param[in] initial value for the elements
      *
      */
-    Matrix<T>(int num_cols, int num_rows, double init_val) : _num_cols(num_cols), _num_rows(num_rows) {
-        _container.resize(num_cols * num_rows);
-        std::fill(_container.begin(), _container.end(), init_val);
+    Matrix<T>(int num_cols, int num_rows, double init_val)
+        : _num_cols(num_cols), _num_rows(num_rows), _stride(padded(num_cols)) {
+        _container.resize(static_cast<std::size_t>(_stride) * num_rows);
+        first_touch(static_cast<T>(init_val));
     }
 
     /**
-     * @brief Constructor without an initial value.
+     * @brief Constructor without an initial value, the elements are zero
      *
      * @param[in] number of elements in x direction
      * @param[in] number of elements in y direction
      *
      */
-    Matrix<T>(int num_cols, int num_rows) : _num_cols(num_cols), _num_rows(num_rows) {
-        _container.resize(num_cols * num_rows);
-    }
+    Matrix<T>(int num_cols, int num_rows) : Matrix<T>(num_cols, num_rows, 0.0) {}
 
     /**
      * @brief Element access and modify using index
@@ -44,7 +115,12 @@ template <typename T> class Matrix {
      * @param[in] y index
      * @param[out] reference to the value
      */
-    T &operator()(int i, int j) { return _container.at(_num_cols * j + i); }
+    T &operator()(int i, int j) {
+#ifdef FLUIDCHEN_BOUNDS_CHECK
+        check(i, j);
+#endif
+        return _container[_stride * j + i];
+    }
 
     /**
      * @brief Element access using index
@@ -53,7 +129,12 @@ template <typename T> class Matrix {
      * @param[in] y index
      * @param[out] value of the element
      */
-    T operator()(int i, int j) const { return _container.at(_num_cols * j + i); }
+    T operator()(int i, int j) const {
+#ifdef FLUIDCHEN_BOUNDS_CHECK
+        check(i, j);
+#endif
+        return _container[_stride * j + i];
+    }
 
     /**
      * @brief Pointer representation of underlying data
@@ -62,10 +143,29 @@ template <typename T> class Matrix {
      */
     const T *data() const { return _container.data(); }
 
+    /**
+     * @brief Mutable pointer representation of underlying data, for kernels
+     * working directly on the row-wise storage
+     *
+     * @param[out] pointer to the beginning of the vector
+     */
+    T *data() { return _container.data(); }
+
+    /**
+     * @brief Pointer to the first element of a row, aligned to 64 bytes
+     *
+     * @param[in] y index of the row
+     */
+    T *row(int j) { return _container.data() + static_cast<std::size_t>(_stride) * j; }
+    const T *row(int j) const { return _container.data() + static_cast<std::size_t>(_stride) * j; }
+
+    /// Distance between the first elements of consecutive rows, the storage index of (i, j) is stride() * j + i
+    int stride() const { return _stride; }
+
     /**
      * @brief Access of the size of the structure
      *
-     * @param[out] size of the data structure
+     * @param[out] number of stored elements including the padding, stride() * num_rows()
      */
     int size() const { return _container.size(); }
 
@@ -73,7 +173,7 @@ template <typename T> class Matrix {
     std::vector<double> get_row(int row) {
         std::vector<T> row_data(_num_cols, -1);
         for (int i = 0; i < _num_cols; ++i) {
-            row_data.at(i) = _container.at(i + _num_cols * row);
+            row_data.at(i) = (*this)(i, row);
         }
         return row_data;
     }
@@ -82,7 +182,7 @@ template <typename T> class Matrix {
     std::vector<double> get_col(int col) {
         std::vector<T> col_data(_num_rows, -1);
         for (int i = 0; i < _num_rows; ++i) {
-            col_data.at(i) = _container.at(col + i * _num_cols);
+            col_data.at(i) = (*this)(col, i);
         }
         return col_data;
     }
@@ -90,14 +190,14 @@ template <typename T> class Matrix {
     /// set the given column of matrix to given vector
     void set_col(const std::vector<double> &vec, int col) {
         for (int i = 0; i < _num_rows; ++i) {
-            _container.at(col + i * _num_cols) = vec.at(i);
+            (*this)(col, i) = vec.at(i);
         }
     }
 
     /// set the given row of matrix to given vector
     void set_row(const std::vector<double> &vec, int row) {
         for (int i = 0; i < _num_cols; ++i) {
-            _container.at(i + row * _num_cols) = vec.at(i);
+            (*this)(i, row) = vec.at(i);
         }
     }
 
@@ -109,9 +209,9 @@ template <typename T> class Matrix {
 
     T max_abs_value() const {
         T max_val = 0;
-        for (int i = 1; i < _num_rows - 1; ++i) { // skip the ghost cells
-            for (int j = 1; j < _num_cols - 1; ++j) {
-                max_val = std::max(max_val, std::abs(_container.at(j + i * _num_cols)));
+        for (int j = 1; j < _num_rows - 1; ++j) { // skip the ghost cells
+            for (int i = 1; i < _num_cols - 1; ++i) {
+                max_val = std::max(max_val, std::abs((*this)(i, j)));
             }
         }
         return max_val;
@@ -119,9 +219,9 @@ template <typename T> class Matrix {
 
     T max_value() const {
         T max_val = 0;
-        for (int i = 1; i < _num_rows - 1; ++i) {
-            for (int j = 1; j < _num_cols - 1; ++j) {
-                max_val = std::max(max_val, _container.at(j + i * _num_cols));
+        for (int j = 1; j < _num_rows - 1; ++j) {
+            for (int i = 1; i < _num_cols - 1; ++i) {
+                max_val = std::max(max_val, (*this)(i, j));
             }
         }
         return max_val;
@@ -129,20 +229,51 @@ template <typename T> class Matrix {
 
     T min_value() const {
         T min_val = 0;
-        for (int i = 1; i < _num_rows - 1; ++i) {
-            for (int j = 1; j < _num_cols - 1; ++j) {
-                min_val = std::min(min_val, _container.at(j + i * _num_cols));
+        for (int j = 1; j < _num_rows - 1; ++j) {
+            for (int i = 1; i < _num_cols - 1; ++i) {
+                min_val = std::min(min_val, (*this)(i, j));
             }
         }
         return min_val;
     }
 
   private:
+    /// Set all elements to the value and the padding to zero, row by row with the partition of the compute loops
+    void first_touch(T value) {
+        auto fill_row = [&](int j) {
+            std::fill(row(j), row(j) + _num_cols, value);
+            std::fill(row(j) + _num_cols, row(j) + _stride, T{});
+        };
+#pragma omp parallel for schedule(static)
+        for (int j = 1; j < _num_rows - 1; ++j) {
+            fill_row(j);
+        }
+        if (_num_rows > 0) {
+            fill_row(0);
+            fill_row(_num_rows - 1);
+        }
+    }
+
+    /// Row length rounded up to the padding
+    static int padded(int num_cols) { return (num_cols + row_padding - 1) / row_padding * row_padding; }
+
+#ifdef FLUIDCHEN_BOUNDS_CHECK
+    void check(int i, int j) const {
+        if (i < 0 or i >= _num_cols or j < 0 or j >= _num_rows) {
+            throw std::out_of_range("Matrix index (" + std::to_string(i) + ", " + std::to_string(j) +
+                                    ") out of range " + std::to_string(_num_cols) + " x " +
+                                    std::to_string(_num_rows));
+        }
+    }
+#endif
+
     /// Number of elements in x direction
-    int _num_cols;
+    int _num_cols{0};
     /// Number of elements in y direction
-    int _num_rows;
+    int _num_rows{0};
+    /// Number of stored elements per row, including the padding
+    int _stride{0};
 
     /// Data container
-    std::vector<T> _container;
+    std::vector<T, AlignedAllocator<T, alignment>> _container;
 };
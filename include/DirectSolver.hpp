@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+
+#include "BandedCholesky.hpp"
+#include "PoissonOperator.hpp"
+#include "PressureSolver.hpp"
+
+/**
+ * @brief Direct solver of the pressure Poisson equation with a cached sparse
+ * Cholesky factor
+ *
+ * The geometry does not change during a run, so the operator of
+ * PoissonOperator is assembled for the whole domain and factorized once in
+ * the constructor. Every time step then costs one forward and one backward
+ * substitution. The unknowns are ordered by reverse Cuthill-McKee to keep the
+ * bandwidth of the factor small; its memory grows with the number of cells
+ * times the shorter extent of the fluid region, so the solver is meant for
+ * small and medium grids. The number of unknowns, the bandwidth and the
+ * memory of the factor are printed at startup.
+ *
+ * Without outflow a connected fluid region has Neumann conditions only, and
+ * its pressure is defined up to a constant. One pressure value of each such
+ * region is pinned to zero, which makes the factorized system regular.
+ *
+ * The factor is held by the first process of MPI_COMMUNICATOR. The right hand
+ * side is gathered there and the pressure scattered back after the solve.
+ *
+ */
+class DirectSolver : public PressureSolver {
+  public:
+    DirectSolver() = default;
+
+    /**
+     * @brief Constructor of the direct solver, assembles and factorizes the operator
+     *
+     * @param[in] grid to take the cell types from
+     */
+    DirectSolver(const Grid &grid);
+
+    virtual ~DirectSolver() = default;
+
+    /**
+     * @brief Solve the pressure equation directly
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Solve the pressure equation directly, always one iteration
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual, not used
+     * @param[in] maximum number of iterations, not used
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+  private:
+    /// Squared residual of the current pressure summed over the fluid cells of this process
+    double residual(Fields &field, const Grid &grid) const;
+
+    PoissonOperator _op;
+    /// Storage indices of the coupled fluid cells of this process, in the order they are gathered
+    std::vector<int> _cells;
+
+    /// Only on the first process: factor, position of each gathered cell in
+    /// the ordering of the factor and the pinned unknowns
+    BandedCholesky _factor;
+    std::vector<int> _position;
+    std::vector<int> _pinned;
+    /// Unknowns of the regions without outflow, in the ordering of the factor
+    std::vector<std::vector<int>> _components;
+    /// Number of gathered cells of every process and their offsets
+    std::vector<int> _counts;
+    std::vector<int> _offsets;
+    int _rank{0};
+
+    /// Gathered right hand side and the solution in the ordering of the factor
+    std::vector<double> _b;
+    std::vector<double> _x;
+};
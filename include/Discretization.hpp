@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "Datastructures.hpp"
 
 /**
@@ -86,3 +88,94 @@ class Discretization {
     static double _dy;
     static double _gamma;
 };
+
+/// Treatment of the convective terms by the upwinding coefficient gamma: 0, 1 or in between
+enum class Upwinding { Central, Full, Blended };
+
+/**
+ * @brief Coefficients of the momentum and temperature equations for the stencil kernels
+ *
+ */
+struct StencilCoefficients {
+    /// inverse cell sizes
+    double idx;
+    double idy;
+    /// upwinding coefficient, only used by the blended kernels
+    double gamma;
+    /// kinematic viscosity
+    double nu;
+    /// thermal diffusivity
+    double alpha;
+    /// timestep size
+    double dt;
+    /// beta * dt / 2 * g, times the sum of the temperatures of the two cells of a face
+    double buoyancy_x;
+    double buoyancy_y;
+};
+
+/**
+ * @brief Row kernels of the explicit momentum and temperature steps, specialized at compile time
+ *
+ * The kernels are instantiated for square cells (dx == dy) or not, for central,
+ * pure donor-cell or blended convection and with or without the Boussinesq
+ * buoyancy term, so the loops have neither branches on these choices nor
+ * arithmetic for terms that vanish. select() picks the instantiation for a
+ * case once at startup. The kernels work on the row-major storage of the
+ * fields, the rows below and above at -stride and +stride, and are vectorized
+ * with versions for AVX-512, AVX2 and the baseline instruction set selected at
+ * runtime where the compiler supports it. They compute in the precision of
+ * the fields, Real, and give the results of the per-cell functions of
+ * Discretization up to rounding.
+ *
+ */
+struct StencilKernels {
+    /**
+     * @brief Kernel computing F = U + dt * (nu * laplacian(U) - convection_u) - buoyancy
+     * or the same for G from V, for the x indices first to last of a row
+     *
+     * @param[in] x-velocity at the first element of the row
+     * @param[in] y-velocity at the first element of the row
+     * @param[in] temperature at the first element of the row, not read without buoyancy
+     * @param[in] distance between the rows of the fields
+     * @param[in] x index of the first cell
+     * @param[in] x index of the last cell
+     * @param[in] coefficients
+     * @param[out] flux at the first element of the row
+     */
+    using FluxRow = void (*)(const Real *U, const Real *V, const Real *T, int stride, int first, int last,
+                             const StencilCoefficients &coefficients, Real *out);
+
+    /**
+     * @brief Kernel of the explicit temperature step, T + dt * (alpha * laplacian(T) - convection_t),
+     * for the x indices first to last of a row, which are fluid cells
+     *
+     * @param[in] temperature at the first element of the row
+     * @param[in] x-velocity at the first element of the row
+     * @param[in] y-velocity at the first element of the row
+     * @param[in] distance between the rows of the fields
+     * @param[in] x index of the first cell
+     * @param[in] x index of the last cell
+     * @param[in] coefficients
+     * @param[out] temperature of the next step at the first element of the row
+     */
+    using TemperatureRow = void (*)(const Real *T, const Real *U, const Real *V, int stride, int first, int last,
+                                    const StencilCoefficients &coefficients, Real *out);
+
+    /**
+     * @brief Instantiation of the kernels for the parameters of a case
+     *
+     * @param[in] cell size in x direction
+     * @param[in] cell size in y direction
+     * @param[in] upwinding coefficient
+     * @param[in] whether the buoyancy term is nonzero
+     */
+    static StencilKernels select(double dx, double dy, double gamma, bool buoyancy);
+
+    FluxRow flux_f{nullptr};
+    FluxRow flux_g{nullptr};
+    TemperatureRow temperature{nullptr};
+    /// upwinding coefficient the kernels were selected for
+    double gamma{0.0};
+    /// description of the instantiation for the output
+    std::string name;
+};
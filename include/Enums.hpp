@@ -1,11 +1,13 @@
 #pragma once
 
+#include <cstdint>
+
 // If no geometry file is provided in the input file, lid driven cavity case
 // will run by default. In the Grid.cpp, geometry will be created following
 // PGM convention
 namespace LidDrivenCavity {
 const int moving_wall_id = 8;
-const int fixed_wall_id = 4;
+const int fixed_wall_id = 3;
 const double wall_velocity = 1.0;
 } // namespace LidDrivenCavity
 
@@ -35,7 +37,7 @@ enum class border_position {
     RIGHT,
 };
 
-enum class cell_type {
+enum class cell_type : std::uint8_t {
     FLUID,
     FIXED_WALL,
     MOVING_WALL,
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <complex>
+#include <vector>
+
+#include "PressureSolver.hpp"
+
+/**
+ * @brief Discrete cosine transform (DCT-II) of a fixed length and its inverse
+ *
+ * Both directions are computed with a complex FFT of the same length after
+ * reordering the input (Makhoul), so a transform costs O(N log N). Lengths
+ * which are not a power of two use Bluestein's algorithm with a power of two
+ * FFT.
+ *
+ * The DCT-II diagonalizes the Laplacian with Neumann conditions at both ends.
+ * With a Dirichlet condition (zero at the face) at one end, the line is
+ * extended antisymmetrically about that face to twice its length, where the
+ * Neumann Laplacian acts like the mixed one. The transform then consists of
+ * the odd wave numbers of the DCT-II of the extended line (a DCT-IV).
+ *
+ */
+class CosineTransform {
+  public:
+    /// Condition at the ends of the lines, at most one end can be Dirichlet
+    enum class Ends { Neumann, DirichletFirst, DirichletLast };
+
+    CosineTransform() = default;
+
+    /**
+     * @brief Constructor, precomputes twiddle factors
+     *
+     * @param[in] length of the transformed lines
+     * @param[in] boundary conditions at the ends of the lines
+     */
+    CosineTransform(int length, Ends ends = Ends::Neumann);
+
+    /**
+     * @brief Forward transform X_k = sum_n x_n cos(pi k (2n + 1) / (2N)) of one line
+     *
+     * @param[in,out] line of values with the given stride
+     * @param[in] distance between consecutive values
+     * @param[in] scratch space of the calling thread
+     */
+    void forward(double *line, int stride, std::vector<std::complex<double>> &scratch) const;
+
+    /**
+     * @brief Inverse of forward()
+     *
+     * @param[in,out] line of values with the given stride
+     * @param[in] distance between consecutive values
+     * @param[in] scratch space of the calling thread
+     */
+    void inverse(double *line, int stride, std::vector<std::complex<double>> &scratch) const;
+
+    /// Size of the scratch space needed by forward() and inverse()
+    int scratch_size() const;
+
+    /**
+     * @brief Eigenvalue of the one-dimensional Laplacian with the boundary conditions of the ends for wave number k
+     *
+     * @param[in] wave number
+     * @param[in] cell size
+     */
+    double eigenvalue(int k, double h) const;
+
+  private:
+    /// In-place FFT of length _n, through Bluestein's algorithm if _n is not a power of two
+    void fft(std::complex<double> *data, std::complex<double> *work, bool inverse) const;
+    /// In-place radix-2 FFT, length must be a power of two
+    void fft_radix2(std::complex<double> *data, int length, bool inverse) const;
+
+    /// Value of the antisymmetric extension of a line with a Dirichlet end at index n
+    double extended(const double *line, int stride, int n) const;
+
+    Ends _ends{Ends::Neumann};
+    /// Length of the lines, _n is twice that with a Dirichlet end
+    int _length{0};
+    int _n{0};
+    /// FFT length of Bluestein's algorithm, 0 if _n is a power of two
+    int _m{0};
+    /// exp(-i pi k / (2N))
+    std::vector<std::complex<double>> _shift;
+    /// Roots of unity of the radix-2 FFT of length _m, or _n if that is a power of two
+    std::vector<std::complex<double>> _roots;
+    /// Chirp exp(-i pi k^2 / N) and the transform of its conjugate, for Bluestein's algorithm
+    std::vector<std::complex<double>> _chirp;
+    std::vector<std::complex<double>> _chirp_hat;
+};
+
+/**
+ * @brief Direct solver of the pressure Poisson equation for domains without
+ * obstacles, inflow and outflow
+ *
+ * On a fully fluid rectangle with Neumann conditions on all walls, the discrete
+ * Laplacian is diagonalized by the cosine transform in both directions. The
+ * pressure is computed exactly by a forward transform of the right hand side,
+ * division by the eigenvalues and an inverse transform, in O(N log N) without
+ * iterations. The constant mode is set to zero.
+ *
+ * In parallel the data is transposed with all-to-all exchanges over
+ * MPI_COMMUNICATOR: from the blocks of the decomposition to pencils of complete
+ * rows for the x transforms, and to pencils of complete columns for the y
+ * transforms and the division.
+ *
+ */
+class FastPoissonSolver : public PressureSolver {
+  public:
+    FastPoissonSolver() = default;
+
+    /**
+     * @brief Constructor of the fast Poisson solver, sets up the transforms and pencils
+     *
+     * @param[in] grid to be used, has to fulfil applicable()
+     */
+    FastPoissonSolver(const Grid &grid);
+
+    virtual ~FastPoissonSolver() = default;
+
+    /**
+     * @brief Whether the fast solver is exact for the grid, i.e. all cells of
+     * the domain are fluid and there is no inflow or outflow on any process
+     *
+     * @param[in] grid to be checked
+     */
+    static bool applicable(const Grid &grid);
+
+    /**
+     * @brief Solve the pressure equation directly
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Solve the pressure equation directly, always one iteration
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual, not used
+     * @param[in] maximum number of iterations, not used
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+    /**
+     * @brief Solve laplacian(x) = b on the inner cells of the whole domain with
+     * Neumann conditions, or the outflow condition on sides that are outflow
+     * along their whole length, the ghost cells are not touched
+     *
+     * @param[in] right hand side
+     * @param[out] solution, with zero mean unless the constant mode is kept
+     * @param[in] keep the constant mode and scale it like the smoothest
+     * nonconstant mode, e.g. for preconditioning a nonsingular operator
+     */
+    void solve_neumann(const Matrix<double> &b, Matrix<double> &x, bool keep_constant = false);
+
+  private:
+    /// Part of the global index space held by a process, [i_begin, i_end) x [j_begin, j_end)
+    struct Box {
+        int i_begin;
+        int i_end;
+        int j_begin;
+        int j_end;
+    };
+
+    /**
+     * @brief Move data between two distributions of the global index space
+     *
+     * Every process sends the overlap of its box in the source distribution with
+     * the box of each process in the target distribution.
+     *
+     * @param[in] boxes of the source distribution
+     * @param[in] boxes of the target distribution
+     * @param[in] local source data
+     * @param[in] storage index of global cell (i, j) in the source data
+     * @param[out] local target data
+     * @param[in] storage index of global cell (i, j) in the target data
+     */
+    template <typename FromIndex, typename ToIndex>
+    void redistribute(const std::vector<Box> &from, const std::vector<Box> &to, const double *source,
+                      FromIndex from_index, double *target, ToIndex to_index) const;
+
+    /// Apply the transform to all local rows / columns
+    void transform_rows(bool inverse);
+    void transform_columns(bool inverse);
+    /// Squared residual of the current pressure summed over the fluid cells of this process
+    double residual(Fields &field, const Grid &grid) const;
+
+    int _imax{0};
+    int _jmax{0};
+    double _dx{1.0};
+    double _dy{1.0};
+    CosineTransform _dct_x;
+    CosineTransform _dct_y;
+    /// Eigenvalues of the one-dimensional Laplacians for all wave numbers
+    std::vector<double> _eigenvalues_x;
+    std::vector<double> _eigenvalues_y;
+
+    /// Blocks of the decomposition and the row and column pencils of all processes
+    std::vector<Box> _blocks;
+    std::vector<Box> _rows;
+    std::vector<Box> _columns;
+    int _rank{0};
+
+    /// Local row pencil, row-wise, and column pencil, column-wise
+    std::vector<double> _row_data;
+    std::vector<double> _column_data;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include "Datastructures.hpp"
 #include "Discretization.hpp"
 #include "Grid.hpp"
@@ -34,7 +36,14 @@ class Fields {
 
     /**
      * @brief Calculates the convective and diffusive fluxes in x and y
-     * direction based on explicit discretization of the momentum equations
+     * direction based on explicit discretization of the momentum equations,
+     * and the right hand side of the pressure Poisson equation
+     *
+     * F, G and the right hand side are computed in one pass over the fluid
+     * spans of the rows (Grid::fluid_spans), the solid cells are skipped.
+     * The right hand side of the cells next to boundaries and at
+     * the subdomain edge depends on fluxes that are set afterwards by the
+     * boundary conditions and the halo exchange, calculate_rs completes it.
      *
      * @param[in] grid in which the fluxes are calculated
      *
@@ -43,7 +52,9 @@ class Fields {
 
     /**
      * @brief Right hand side calculations using the fluxes for the pressure
-     * Poisson equation
+     * Poisson equation, for the cells of Grid::flux_boundary_cells
+     *
+     * The right hand side of all other cells is computed by calculate_fluxes.
      *
      * @param[in] grid in which the calculations are done
      *
@@ -53,6 +64,10 @@ class Fields {
     /**
      * @brief Velocity calculation using pressure values
      *
+     * Updates the velocities of the faces of the fluid cells, the ones inside
+     * obstacles are left to the boundary conditions. Also finds the maximum
+     * absolute velocities of the subdomain for calculate_dt.
+     *
      * @param[in] grid in which the calculations are done
      *
      */
@@ -61,6 +76,9 @@ class Fields {
      /**
      * @brief temperature calculation
      *
+     * Explicit step of the temperature equation in the fluid cells, all other
+     * cells keep their temperature.
+     *
      * @param[in] grid in which the calculations are done
      *
      */
@@ -70,16 +88,53 @@ class Fields {
      * @brief Adaptive step size calculation using x-velocity condition,
      * y-velocity condition and CFL condition
      *
+     * The maximum velocities are the ones found by the last
+     * calculate_velocities, or the initial ones.
+     *
      * @param[in] grid in which the calculations are done
      *
      */
     void calculate_dt(Grid &grid);
 
+    /**
+     * @brief Set the stencil kernels of calculate_fluxes and calculate_temperature
+     *
+     * @param[in] kernels selected for the case, see StencilKernels::select
+     *
+     */
+    void set_kernels(const StencilKernels &kernels);
+
+    /**
+     * @brief Store the current pressure in the ring buffer of past pressure
+     * fields
+     *
+     * @param[in] time the pressure belongs to
+     *
+     */
+    void store_pressure(double time);
+
+    /**
+     * @brief Set the pressure to the extrapolation of the stored pressure fields
+     * to the given time, as initial guess of the pressure solver
+     *
+     * The extrapolation polynomial goes through the latest stored fields at
+     * their own times, so changes of the timestep size are taken into account.
+     * Does nothing while fewer than two fields are stored.
+     *
+     * @param[in] time to extrapolate to
+     * @param[in] order of the extrapolation, 1 for linear, 2 for quadratic
+     *
+     */
+    void extrapolate_pressure(double time, int order);
+
+    /// Empty the ring buffer of past pressure fields
+    void clear_pressure_history();
+
     /// x-velocity index based access and modify
-    double &u(int i, int j);
+    Real &u(int i, int j);
 
     /// y-velocity index based access and modify
-    double &v(int i, int j);
+    Real &v(int i, int j);
 
     /// pressure index based access and modify
     double &p(int i, int j);
@@ -88,14 +143,14 @@ class Fields {
     double &rs(int i, int j);
 
     /// x-momentum flux index based access and modify
-    double &f(int i, int j);
+    Real &f(int i, int j);
 
     /// y-momentum flux index based access and modify
-    double &g(int i, int j);
+    Real &g(int i, int j);
 
 
     /// temperature index based access and modify
-    double &T(int i, int j);
+    Real &T(int i, int j);
 
     /// get timestep size
     double dt() const;
@@ -104,38 +159,54 @@ class Fields {
     Matrix<double> &p_matrix();
 
     /// velocity u matrix access and modify
-    Matrix<double> &u_matrix();
+    Matrix<Real> &u_matrix();
 
     /// velocity v matrix access and modify
-    Matrix<double> &v_matrix();
+    Matrix<Real> &v_matrix();
 
     /// f matrix access and modify
-    Matrix<double> &f_matrix();
+    Matrix<Real> &f_matrix();
 
     /// g pressure matrix access and modify
-    Matrix<double> &g_matrix();
+    Matrix<Real> &g_matrix();
 
     /// RHS matrix access and modify
     Matrix<double> &rs_matrix();
 
     /// temperature matrix access and modify
-    Matrix<double> &t_matrix();
+    Matrix<Real> &t_matrix();
 
   private:
+    /// Coefficients of the stencil kernels for the current timestep size
+    StencilCoefficients stencil_coefficients(const Grid &grid) const;
+
     /// x-velocity matrix
-    Matrix<double> _U;
+    Matrix<Real> _U;
     /// y-velocity matrix
-    Matrix<double> _V;
+    Matrix<Real> _V;
     /// pressure matrix
     Matrix<double> _P;
     /// x-momentum flux matrix
-    Matrix<double> _F;
+    Matrix<Real> _F;
     /// y-momentum flux matrix
-    Matrix<double> _G;
+    Matrix<Real> _G;
     /// right hand side matrix
     Matrix<double> _RS;
     /// temperature matrix
-    Matrix<double> _T;
+    Matrix<Real> _T;
+    /// temperature of the next timestep, swapped with _T by calculate_temperature
+    Matrix<Real> _T_next;
+
+    /// ring buffer of past pressure fields, the latest at _history_head
+    std::array<Matrix<double>, 3> _p_history;
+    /// times of the past pressure fields
+    std::array<double, 3> _t_history{};
+    int _history_head{0};
+    int _history_size{0};
+
+    /// maximum absolute velocities in the subdomain, for the timestep size
+    double _u_max{0.0};
+    double _v_max{0.0};
 
     /// kinematic viscosity
     double _nu;
@@ -150,4 +221,7 @@ class Fields {
     /// thermal diffusivity
     double _alpha;
     double _beta;
+
+    /// momentum and temperature kernels specialized for the case
+    StencilKernels _kernels;
 };
@@ -11,9 +11,60 @@
 #include "Domain.hpp"
 #include "Enums.hpp"
 
+/// Fluid cells with the x indices first to last in a row
+struct FluidSpan {
+    int first;
+    int last;
+};
+
+/**
+ * @brief Fluid cells of a subdomain as runs of contiguous cells per row
+ *
+ * Kernels loop over the spans of a row instead of the whole row, so they skip
+ * the solid regions and their inner loops need no test of the cell type.
+ *
+ */
+class FluidSpans {
+  public:
+    /// Spans of one row in ascending x, for range-based for loops
+    struct Row {
+        const FluidSpan *spans_begin;
+        const FluidSpan *spans_end;
+        const FluidSpan *begin() const { return spans_begin; }
+        const FluidSpan *end() const { return spans_end; }
+    };
+
+    FluidSpans() = default;
+
+    /**
+     * @brief Collect the spans of the rows 1 to num_rows() - 2 from the cell types
+     *
+     * @param[in] type of every cell including the ghost layer, as cell_type
+     */
+    explicit FluidSpans(const Matrix<std::uint8_t> &types);
+
+    /// spans of row j
+    Row row(int j) const {
+        return {_spans.data() + _row_start[j], _spans.data() + _row_start[j + 1]};
+    }
+
+    /// number of spans of all rows
+    int size() const { return _spans.size(); }
+
+  private:
+    std::vector<FluidSpan> _spans;
+    /// the spans of row j are _spans[_row_start[j]] to _spans[_row_start[j + 1] - 1]
+    std::vector<int> _row_start;
+};
+
 /**
  * @brief Data structure holds cells and related sub-containers
  *
+ * The cells are stored as flag arrays in the layout of the fields: one byte
+ * for the type, the wall id and the borders of every cell. Cell objects are
+ * created from these on access, the neighbours of a cell follow from its
+ * indices.
+ *
  */
 class Grid {
   public:
@@ -28,7 +79,7 @@ class Grid {
      */
     Grid(std::string geom_name, Domain &domain);
 
-    /// index based cell access
+    /// index based cell access, the cell is created from the flag arrays
     Cell cell(int i, int j) const;
 
     /// access number of cells in x direction
@@ -54,33 +105,51 @@ class Grid {
      *
      * @param[out] vector of fluid cells
      */
-    const std::vector<Cell *> &fluid_cells() const;
+    const std::vector<Cell> &fluid_cells() const;
 
     /**
      * @brief Access moving wall cells
      *
      * @param[out] vector of moving wall cells
      */
-    const std::vector<Cell *> &moving_wall_cells() const;
+    const std::vector<Cell> &moving_wall_cells() const;
 
     /**
      * @brief Access fixed wall cells
      *
      * @param[out] vector of fixed wall cells
      */
-    const std::vector<Cell *> &fixed_wall_cells() const;
+    const std::vector<Cell> &fixed_wall_cells() const;
 
-    const std::vector<Cell *> &fixed_velocity_cells() const;
+    const std::vector<Cell> &fixed_velocity_cells() const;
 
-    const std::vector<Cell *> &zero_gradient_cells() const;
+    const std::vector<Cell> &zero_gradient_cells() const;
 
-    const std::vector<Cell *> &inner_obstacle_cells() const;
+    const std::vector<Cell> &inner_obstacle_cells() const;
 
-    const std::vector<Cell *> &hot_wall_cells() const;
+    const std::vector<Cell> &hot_wall_cells() const;
 
-    const std::vector<Cell *> &cold_wall_cells() const;
+    const std::vector<Cell> &cold_wall_cells() const;
+
+    const std::vector<Cell> &ghost_cells() const;
+
+    /**
+     * @brief Access the cells whose pressure right hand side depends on fluxes set by the
+     * boundary conditions or received from the neighbour processes
+     *
+     * These are the cells of the subdomain next to a boundary cell, or a boundary cell
+     * themselves, and the cells of the first row and column, see Fields::calculate_rs.
+     *
+     * @param[out] vector of cells
+     */
+    const std::vector<Cell> &flux_boundary_cells() const;
 
-    const std::vector<Cell *> &ghost_cells() const;
+    /**
+     * @brief Access the fluid cells as runs of contiguous cells per row
+     *
+     * @param[out] spans of the rows of the subdomain
+     */
+    const FluidSpans &fluid_spans() const;
 
   private:
     /**@brief Default lid driven cavity case generator
@@ -94,23 +163,31 @@ class Grid {
     void assign_cell_types(std::vector<std::vector<int>> &geometry_data);
     /// Extract geometry from pgm file and create geometrical data
     void parse_geometry_file(std::string filedoc, std::vector<std::vector<int>> &geometry_data);
-
-    /// Actual matrix of all cells (including ghost cells)
-    Matrix<Cell> _cells;
-    /// Vector of pointers to all fluid cells
-    std::vector<Cell *> _fluid_cells;
-    /// Vector of pointers to all cells belonging to fixed walls
-    std::vector<Cell *> _fixed_wall_cells;
-    /// Vector of pointers to all cells belonging to moving walls
-    std::vector<Cell *> _moving_wall_cells;
-
-    std::vector<Cell *> _fixed_velocity_cells;
-    std::vector<Cell *> _zero_gradient_cells;
-    std::vector<Cell *> _inner_obstacle_cells;
-
-    std::vector<Cell *> _cold_wall_cells;
-    std::vector<Cell *> _hot_wall_cells;
-    std::vector<Cell *> _ghost_cells;
+    /// Build the fluid spans and the cells of flux_boundary_cells() once the types and borders are known
+    void build_cell_lists();
+
+    /// Type of every cell (including ghost cells) as cell_type
+    Matrix<std::uint8_t> _types;
+    /// Geometry id of every wall cell
+    Matrix<std::uint8_t> _wall_ids;
+    /// Borders of every cell to fluid cells, bit 1 << border_position for every border
+    Matrix<std::uint8_t> _borders;
+    /// Vector of all fluid cells
+    std::vector<Cell> _fluid_cells;
+    /// Vector of all cells belonging to fixed walls
+    std::vector<Cell> _fixed_wall_cells;
+    /// Vector of all cells belonging to moving walls
+    std::vector<Cell> _moving_wall_cells;
+
+    std::vector<Cell> _fixed_velocity_cells;
+    std::vector<Cell> _zero_gradient_cells;
+    std::vector<Cell> _inner_obstacle_cells;
+
+    std::vector<Cell> _cold_wall_cells;
+    std::vector<Cell> _hot_wall_cells;
+    std::vector<Cell> _ghost_cells;
+    std::vector<Cell> _flux_boundary_cells;
+    FluidSpans _fluid_spans;
 
     /// Domain object holding geometrical information
     Domain _domain;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "PoissonOperator.hpp"
+#include "PressureSolver.hpp"
+
+/**
+ * @brief Zebra line SOR for the pressure Poisson equation on anisotropic cells
+ *
+ * Point relaxation converges slowly if the coupling in one direction is much
+ * stronger than in the other, i.e. for dx != dy. Line relaxation solves for
+ * all cells of a grid line along the strongly coupled direction at once with
+ * the Thomas algorithm, the couplings across the line are taken from the
+ * current pressure. Lines are along x if dx <= dy and along y otherwise.
+ *
+ * The coefficients are the ones of PoissonOperator, so walls, obstacles and
+ * outflows are part of the tridiagonal systems: a line is split into segments
+ * of fluid cells connected by open faces, and a segment also ends at the
+ * subdomain, where the halo values enter explicitly. Lines of even and odd
+ * global index are relaxed alternately (zebra ordering). The lines of one color
+ * only couple to lines of the other color, so they are independent and are
+ * relaxed by parallel threads, followed by one halo exchange per color. If the
+ * lines are cut by the decomposition, the processes with even position along
+ * the lines relax a color before the ones with odd position, at the cost of a
+ * second halo exchange per color, since relaxing both parts of a line at once
+ * is block Jacobi across the cut, which diverges for larger relaxation factors.
+ *
+ */
+class LineSOR : public RelaxationSolver {
+  public:
+    LineSOR() = default;
+
+    /**
+     * @brief Constructor of line SOR solver, picks the direction and splits the lines
+     *
+     * @param[in] (initial) relaxation factor
+     * @param[in] grid to take the cell types and sizes from
+     * @param[in] adapt the relaxation factor to the measured convergence rate
+     */
+    LineSOR(double omega, const Grid &grid, bool adaptive = false);
+
+    virtual ~LineSOR() = default;
+
+    /**
+     * @brief Relax the lines of both colors once
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+  private:
+    /// Consecutive coupled fluid cells of a line, connected by open faces
+    struct Segment {
+        /// Storage index of the first cell
+        int first;
+        int length;
+    };
+
+    /**
+     * @brief Relax all segments of one color
+     *
+     * @param[in,out] pressure
+     * @param[in] right hand side
+     * @param[in] color, 0 or 1
+     * @return sum of the squared residuals of the relaxed cells before their update
+     */
+    double sweep(Matrix<double> &P, const Matrix<double> &RS, int color);
+
+    PoissonOperator _op;
+    /// Whether the lines run along x, otherwise along y
+    bool _along_x{true};
+    /// Segments of the lines of even and odd global index
+    std::array<std::vector<Segment>, 2> _segments;
+    int _max_length{0};
+    /// Whether some lines are cut by the decomposition, and the parity of the process along the lines
+    bool _ordered{false};
+    int _phase{0};
+    /// Corner link neighbours of every cell in CSR format, see PoissonOperator
+    std::vector<int> _link_start;
+    std::vector<int> _link_neighbour;
+};
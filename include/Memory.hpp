@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/// Page backing requested for the storage of large matrices
+enum class HugePages { None, Transparent, Explicit };
+
+/**
+ * @brief Allocation of the matrix storage and report of its placement
+ *
+ * Allocations of at least one huge page are mapped directly, rounded up to
+ * whole huge pages and aligned to them. Depending on the policy they are
+ * advised to be backed by transparent huge pages or mapped from the reserved
+ * huge pages of the system (vm.nr_hugepages), falling back to transparent huge
+ * pages if none are available. Smaller allocations use aligned operator new.
+ * The memory is not touched here, so its pages are placed on the NUMA node of
+ * the thread that first writes to them (see Matrix).
+ *
+ */
+class Memory {
+  public:
+    /**
+     * @brief Set the page backing of the following allocations
+     *
+     * @param[in] requested huge pages
+     */
+    static void set_huge_pages(HugePages policy);
+
+    /**
+     * @brief Page backing from its name in the case file
+     *
+     * @param[in] none, transparent or explicit
+     */
+    static HugePages huge_pages_from_string(const std::string &name);
+
+    /**
+     * @brief Allocate uninitialized memory
+     *
+     * @param[in] number of bytes
+     * @param[in] alignment in bytes, at most the page size
+     */
+    static void *allocate(std::size_t bytes, std::size_t alignment);
+
+    /**
+     * @brief Release memory of allocate
+     *
+     * @param[in] pointer returned by allocate
+     * @param[in] number of bytes passed to allocate
+     * @param[in] alignment passed to allocate
+     */
+    static void deallocate(void *data, std::size_t bytes, std::size_t alignment);
+
+    /**
+     * @brief Description of the pages backing a memory range and of the NUMA
+     * nodes they are placed on, e.g. for the startup output
+     *
+     * @param[in] first byte of the range
+     * @param[in] number of bytes
+     */
+    static std::string placement(const void *data, std::size_t bytes);
+
+  private:
+    static HugePages _policy;
+    /// Set if an explicit huge page mapping failed and transparent ones were used
+    static bool _explicit_failed;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Datastructures.hpp"
+#include "PressureSolver.hpp"
+
+/**
+ * @brief Mixed-precision solver for the pressure Poisson equation
+ *
+ * An outer iterative refinement in double precision computes the residual of
+ * the pressure with Discretization::laplacian and the real boundary conditions.
+ * The correction equation A e = r is then relaxed by red-black SOR sweeps on
+ * float copies of the residual and the correction, which moves half the bytes
+ * of the double sweeps, before the correction is added to the pressure. The
+ * boundary conditions of the correction are part of the diagonal of
+ * PoissonOperator, so the float sweeps do not touch the boundaries.
+ *
+ * The inner sweeps reduce the residual by a fixed factor per refinement step,
+ * within the accuracy of float, while the outer residual reaches the tolerance
+ * of the case in double precision. A refinement step ends early when the float
+ * residual drops below the tolerance, and after at most 50 sweeps, so the
+ * double residual is checked at least that often. Cells next to wall corners are relaxed in a
+ * short scalar pass with the corner links of PoissonOperator.
+ *
+ */
+class MixedPrecisionSOR : public PressureSolver {
+  public:
+    MixedPrecisionSOR() = default;
+
+    /**
+     * @brief Constructor of mixed-precision solver
+     *
+     * @param[in] relaxation factor of the inner sweeps
+     * @param[in] grid to take the cell types from
+     */
+    MixedPrecisionSOR(double omega, const Grid &grid);
+
+    virtual ~MixedPrecisionSOR() = default;
+
+    /**
+     * @brief Perform one refinement step on the pressure equation
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Refine the pressure until the residual is below the tolerance,
+     * counting the inner sweeps as iterations
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual
+     * @param[in] maximum number of iterations
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+    /**
+     * @brief Number of refinement steps of the last solve_system call
+     *
+     */
+    virtual std::string statistics() const;
+
+  private:
+    /**
+     * @brief Store the double residual of the pressure in float
+     *
+     * @return sum of the squared residuals over the fluid cells of this process
+     */
+    double residual(Fields &field, const Grid &grid);
+
+    /**
+     * @brief Relax the correction equation in float until the RMS of its
+     * residual is below the target or the tolerance
+     *
+     * The residual of the correction equation estimates the residual of the
+     * corrected pressure, so below the tolerance the pressure is checked in
+     * double. The estimate is taken before the update of every cell and can
+     * level off above the residual of the pressure, so the sweeps are limited
+     * as well.
+     *
+     * @param[in] target of the residual
+     * @param[in] tolerance of the pressure residual
+     * @param[in] maximum number of sweeps
+     * @return number of performed sweeps
+     */
+    int correct(double target, double tolerance, int max_sweeps);
+
+    /**
+     * @brief Add the correction to the pressure and update its boundaries
+     *
+     */
+    void update(Fields &field, const Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Relax the correction on the fluid cells of one color
+     *
+     * @param[in] color, 0 or 1
+     * @return sum of the squared residuals of the relaxed cells before their update
+     */
+    double sweep(int color);
+
+    /// Fluid cell coupled to diagonal neighbours over wall corners, see PoissonOperator
+    struct LinkedCell {
+        int cell;
+        float inv_diag;
+        std::vector<int> neighbours;
+    };
+
+    double _omega{1.0};
+    double _idx2{1.0};
+    double _idy2{1.0};
+    /// Color of cell (i, j) is (i + j + _parity) % 2, consistent over all ranks
+    int _parity{0};
+    /// Inverse diagonal of the fluid cells of the respective color without corner links, 0 otherwise
+    std::array<Matrix<float>, 2> _inv_diag;
+    /// Fluid cells of the respective color with corner links
+    std::array<std::vector<LinkedCell>, 2> _linked;
+    double _corner_weight{0.0};
+    FluidSpans _spans;
+    /// Residual of the pressure and correction in float
+    Matrix<float> _r;
+    Matrix<float> _e;
+    /// Refinement steps of the last solve_system call
+    int _steps{0};
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Datastructures.hpp"
+#include "PressureSolver.hpp"
+
+/**
+ * @brief Geometric multigrid for solution of pressure Poisson equation
+ *
+ * Builds a hierarchy of coarse grids from the cell types of the Grid. A coarse
+ * cell is fluid if any of its fine cells is fluid. The coarse operators are
+ * rediscretized with the fraction of each coarse face that is open fluid-fluid
+ * or outflow on the fine grid, so thin walls of the geometry keep separating the
+ * flow on all levels. Walls and inflows give Neumann, outflows Dirichlet
+ * conditions, like the applyPressure methods of the boundaries.
+ *
+ * Every call of solve() performs one V- or W-cycle with red-black Gauss-Seidel
+ * smoothing. Coarsening is done locally on every rank, the ghost layer of the
+ * coarse grids is exchanged like the one of the fine grid.
+ *
+ */
+class Multigrid : public PressureSolver {
+  public:
+    Multigrid() = default;
+
+    /**
+     * @brief Constructor of multigrid solver, builds the grid hierarchy
+     *
+     * @param[in] grid to be coarsened
+     * @param[in] number of coarse grid visits per cycle, 1 for V-cycle, 2 for W-cycle
+     * @param[in] number of pre- and post-smoothing sweeps
+     */
+    Multigrid(const Grid &grid, int cycle_index, int smoothing_steps);
+
+    virtual ~Multigrid() = default;
+
+    /**
+     * @brief Perform one multigrid cycle on the pressure equation
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+  private:
+    /// Data of one grid level, level 0 is the grid of the simulation
+    struct Level {
+        /// Number of inner cells
+        int size_x;
+        int size_y;
+        double dx;
+        double dy;
+        /// Global index of the first cell, defines the red-black coloring
+        int iminb;
+        int jminb;
+        /// Whether this level is coarser than the previous one in x / y
+        bool coarsened_x{false};
+        bool coarsened_y{false};
+
+        /// Correction and restricted residual, unused on level 0
+        Matrix<double> p;
+        Matrix<double> rhs;
+        /// Residual of the current iterate
+        Matrix<double> res;
+        /// 1 for fluid cells, including the ghost layer
+        Matrix<double> fluid;
+        /// Open fraction of the face to the right / upper neighbour
+        Matrix<double> open_x;
+        Matrix<double> open_y;
+        /// Outflow fraction of the faces of a cell, indexed by DIRECTIONS
+        std::array<Matrix<double>, 4> outflow;
+        /// Diagonal of the discrete operator and its inverse, 0 for uncoupled cells
+        Matrix<double> diag;
+        Matrix<double> inv_diag;
+        /// 1 for coupled fluid cells of the respective color, 0 otherwise
+        std::array<Matrix<double>, 2> mask;
+    };
+
+    /// Allocate the fields of a level and compute diagonal and masks from the face fractions
+    void finalize_level(Level &level);
+    /// Build the next coarser level
+    Level coarsen(const Level &fine, bool coarsen_x, bool coarsen_y);
+
+    void cycle(int l, Matrix<double> &P, const Matrix<double> &RS, Fields &field,
+               const std::vector<std::unique_ptr<Boundary>> &boundaries);
+    void smooth(int l, Matrix<double> &P, const Matrix<double> &RS, int sweeps, double omega, Fields &field,
+                const std::vector<std::unique_ptr<Boundary>> &boundaries);
+    /// Red-black Gauss-Seidel sweep over one color with the operator of a coarse level
+    void sweep(const Level &level, Matrix<double> &P, const Matrix<double> &RS, int color, double omega);
+    /// Residual RS - A * P on fluid cells, returns the local sum of squares
+    double residual(int l, const Matrix<double> &P, const Matrix<double> &RS);
+    void restrict_residual(int l);
+    void prolongate_correction(int l, Matrix<double> &P);
+
+    std::vector<Level> _levels;
+    int _cycle_index{1};
+    int _smoothing_steps{2};
+    /// Sweeps and relaxation factor of the SOR solve on the coarsest level
+    int _coarse_sweeps{0};
+    double _coarse_omega{1.0};
+    /// True if no rank has an outflow, i.e. the pressure is only defined up to a constant
+    bool _pure_neumann{true};
+};
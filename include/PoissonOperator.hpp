@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "Datastructures.hpp"
+#include "Enums.hpp"
+#include "Grid.hpp"
+
+/**
+ * @brief Matrix-free five-point operator of the pressure Poisson equation
+ *
+ * Applies the stencil of Discretization::laplacian with flipped sign, A = -laplacian,
+ * on the fluid cells of the subdomain. The boundary conditions are part of the
+ * face coefficients instead of the ghost cell values: faces to walls, obstacles
+ * and inflows are closed (Neumann), faces to outflow cells add the Dirichlet
+ * term of p_ghost = -p to the diagonal. Faces at subdomain interfaces are open and
+ * use the halo values. A wall cell with two fluid neighbours takes their average
+ * (see FixedWallBoundary::build_tables), which couples the two neighbours. This is
+ * kept as a symmetric corner link, so the operator stays symmetric positive
+ * (semi-)definite and equals the one of the SOR solvers for dx == dy.
+ *
+ */
+class PoissonOperator {
+  public:
+    /// Coupling of a fluid cell to a diagonal neighbour over a wall corner, as storage indices
+    struct CornerLink {
+        int cell;
+        int neighbour;
+    };
+
+    PoissonOperator() = default;
+
+    /**
+     * @brief Constructor of the operator, computes the face coefficients
+     *
+     * @param[in] grid to take the cell types from
+     */
+    PoissonOperator(const Grid &grid);
+
+    /**
+     * @brief Apply the operator, y = A x on the coupled fluid cells and 0 on the
+     * other fluid cells
+     *
+     * The halo of x is exchanged before, the ghost cells at the physical
+     * boundaries are not read. Only the fluid spans of y are written, the
+     * solid cells keep their value, which stays zero for the vectors of the
+     * solvers.
+     *
+     * @param[in] vector to apply the operator to
+     * @param[out] result
+     */
+    void apply(Matrix<double> &x, Matrix<double> &y) const;
+
+    /**
+     * @brief Dot product over the coupled fluid cells of this process
+     *
+     * @param[in] first vector
+     * @param[in] second vector
+     */
+    double local_dot(const Matrix<double> &a, const Matrix<double> &b) const;
+
+    /// 1 for fluid cells, including the ghost layer
+    const Matrix<double> &fluid() const;
+    /// Open fraction of the face to the right / upper neighbour
+    const Matrix<double> &open_x() const;
+    const Matrix<double> &open_y() const;
+    /// 1 for fluid cells with the given face on an outflow
+    const Matrix<double> &outflow(DIRECTIONS direction) const;
+    /// Diagonal of the operator including corner links and its inverse, 0 for uncoupled cells
+    const Matrix<double> &diag() const;
+    const Matrix<double> &inv_diag() const;
+    /// 1 for fluid cells coupled to at least one neighbour or outflow
+    const Matrix<double> &mask() const;
+
+    /// Corner links of the cells of this process and their weight, entering with negative sign
+    const std::vector<CornerLink> &corner_links() const;
+    double corner_weight() const;
+
+    /// Squared inverse cell sizes
+    double idx2() const;
+    double idy2() const;
+
+    /// Number of coupled fluid cells of all processes
+    double global_cells() const;
+    /// True if no process has an outflow, the pressure is only defined up to a constant then
+    bool singular() const;
+
+  private:
+    double _idx2{1.0};
+    double _idy2{1.0};
+    Matrix<double> _fluid;
+    Matrix<double> _open_x;
+    Matrix<double> _open_y;
+    std::array<Matrix<double>, 4> _outflow;
+    Matrix<double> _diag;
+    Matrix<double> _inv_diag;
+    Matrix<double> _mask;
+    std::vector<CornerLink> _corner_links;
+    FluidSpans _spans;
+    double _corner_weight{0.0};
+    double _global_cells{0.0};
+    bool _singular{true};
+};
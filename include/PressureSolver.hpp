@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "Boundary.hpp"
 #include "Fields.hpp"
@@ -13,16 +16,137 @@
 class PressureSolver {
   public:
     PressureSolver() = default;
+
+    /**
+     * @brief Constructor of the solver, counts the fluid cells of all processes
+     *
+     * @param[in] grid to be used
+     */
+    explicit PressureSolver(const Grid &grid);
+
     virtual ~PressureSolver() = default;
 
     /**
      * @brief Solve the pressure equation on given field, grid and boundary
      *
+     * Performs one iteration and returns the sum of the squared residuals over
+     * the fluid cells of this process.
+     *
      * @param[in] field to be used
      * @param[in] grid to be used
      * @param[in] boundary to be used
      */
     virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries) = 0;
+
+    /**
+     * @brief Iterate the pressure equation until the residual is below the
+     * tolerance or the maximum number of iterations is reached
+     *
+     * The default repeats solve() and checks the RMS of the residual over the
+     * fluid cells of all processes every residual_interval iterations. Solvers
+     * which keep state over the iterations of one time step override it.
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual
+     * @param[in] maximum number of iterations
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+    /**
+     * @brief Set the number of iterations between two convergence checks,
+     * each of them needs a global reduction
+     *
+     * @param[in] number of iterations
+     */
+    void set_residual_interval(int interval);
+
+    /**
+     * @brief Solver specific statistics of the last solve_system call, printed
+     * after the iteration count and residual of each timestep
+     *
+     */
+    virtual std::string statistics() const;
+
+  protected:
+    int _residual_interval{1};
+    /// Number of fluid cells of all processes, for the RMS of the residual
+    double _global_cells{1.0};
+};
+
+/**
+ * @brief Base of the SOR solvers, with an optional online estimate of the
+ * optimal relaxation factor
+ *
+ * The convergence rate rho of the residual at the current relaxation factor
+ * omega gives the spectral radius mu of the Jacobi iteration through Young's
+ * relation (rho + omega - 1)^2 = rho omega^2 mu^2, valid for consistently
+ * ordered sweeps, and with it the optimal factor 2 / (1 + sqrt(1 - mu^2)).
+ * After each timestep the factor moves towards this estimate. Once the rate is
+ * limited by omega - 1 the factor is at or above the optimum and is slowly
+ * decreased again, so it keeps following drifts of the rate. If the residual
+ * grows before the last check, the iteration restarts with a smaller factor,
+ * and if a larger factor converges slower than the previous one, both bound
+ * all later estimates.
+ *
+ */
+class RelaxationSolver : public PressureSolver {
+  public:
+    RelaxationSolver() = default;
+
+    /**
+     * @brief Constructor of the relaxation solver
+     *
+     * @param[in] (initial) relaxation factor
+     * @param[in] grid to be used
+     * @param[in] adapt the relaxation factor to the measured convergence rate
+     */
+    RelaxationSolver(double omega, const Grid &grid, bool adaptive);
+
+    virtual ~RelaxationSolver() = default;
+
+    /**
+     * @brief Iterate the pressure equation, then adapt the relaxation factor
+     * for the next call if enabled
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual
+     * @param[in] maximum number of iterations
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+    /**
+     * @brief Relaxation factor used in the last solve_system call, if adaptive
+     *
+     */
+    virtual std::string statistics() const;
+
+  protected:
+    double _omega{1.0};
+
+  private:
+    /**
+     * @brief Move the relaxation factor towards the optimum estimated from the
+     * residuals of the previous solve_system call
+     *
+     */
+    void adapt();
+
+    bool _adaptive{false};
+    /// Largest relaxation factor, lowered whenever the iteration diverged or slowed down
+    double _omega_limit{2.0};
+    /// Relaxation factor and convergence rate of the last accepted estimate
+    double _previous_omega{0.0};
+    double _previous_rho{1.0};
+    /// Iteration count and residual of each convergence check of the last solve_system call
+    std::vector<std::pair<int, double>> _residual_history;
 };
 
 /**
@@ -30,16 +154,18 @@ class PressureSolver {
  * equation
  *
  */
-class SOR : public PressureSolver {
+class SOR : public RelaxationSolver {
   public:
     SOR() = default;
 
     /**
      * @brief Constructor of SOR solver
      *
-     * @param[in] relaxation factor
+     * @param[in] (initial) relaxation factor
+     * @param[in] grid to be used
+     * @param[in] adapt the relaxation factor to the measured convergence rate
      */
-    SOR(double omega);
+    SOR(double omega, const Grid &grid, bool adaptive = false);
 
     virtual ~SOR() = default;
 
@@ -51,7 +177,63 @@ class SOR : public PressureSolver {
      * @param[in] boundary to be used
      */
     virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+};
+
+/**
+ * @brief Red-black (checkerboard) Successive Over-Relaxation for solution of
+ * pressure Poisson equation
+ *
+ * Both colors are updated in separate unit-stride passes over the fluid spans
+ * of the rows. Fluid cells of a color are selected by a precomputed mask instead
+ * of a branch on the cell, so the inner loops are branch-free and can be
+ * vectorized and threaded over rows. After each color only the halo values of
+ * that color are exchanged.
+ *
+ */
+class RedBlackSOR : public RelaxationSolver {
+  public:
+    RedBlackSOR() = default;
+
+    /**
+     * @brief Constructor of red-black SOR solver
+     *
+     * @param[in] (initial) relaxation factor
+     * @param[in] grid to build the color masks from
+     * @param[in] adapt the relaxation factor to the measured convergence rate
+     */
+    RedBlackSOR(double omega, const Grid &grid, bool adaptive = false);
+
+    virtual ~RedBlackSOR() = default;
+
+    /**
+     * @brief Solve the pressure equation on given field, grid and boundary
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Relax all cells selected by the mask, i.e. the fluid cells of one
+     * color, in place
+     *
+     * @param[in] pressure (or correction) to be relaxed
+     * @param[in] right hand side
+     * @param[in] 1 for the cells to relax, 0 otherwise
+     * @param[in] offset of the color, only cells with i + j + offset even are visited
+     * @param[in] cell size in x direction
+     * @param[in] cell size in y direction
+     * @param[in] relaxation factor
+     * @param[in] fluid spans the rows are restricted to, whole rows if null
+     * @return sum of the squared residuals of the relaxed cells before their update
+     */
+    static double sweep(Matrix<double> &P, const Matrix<double> &RS, const Matrix<double> &mask, int offset, double dx,
+                        double dy, double omega, const FluidSpans *spans = nullptr);
 
   private:
-    double _omega;
+    /// Color of cell (i, j) is (i + j + _parity) % 2, consistent over all ranks
+    int _parity{0};
+    /// 1 for fluid cells of the respective color, 0 otherwise
+    std::array<Matrix<double>, 2> _mask;
 };
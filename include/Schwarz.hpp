@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "BandedCholesky.hpp"
+#include "Datastructures.hpp"
+#include "Grid.hpp"
+#include "PoissonOperator.hpp"
+
+/**
+ * @brief Two-level additive Schwarz preconditioner for the pressure Poisson
+ * equation
+ *
+ * The subdomain of each process is extended by the fluid cells of its ghost
+ * layer at process interfaces, so neighbouring subdomains overlap by one cell
+ * on each side. The operator on the extended subdomain, with zero Dirichlet
+ * conditions beyond it, is factorized once by banded Cholesky, since the
+ * decomposition and the geometry do not change. Applying the preconditioner
+ * solves the local problems, adds the overlapping parts of the solutions to the
+ * processes owning the cells and adds a coarse correction by aggregation: the
+ * coupled cells in each of 4 x 4 boxes of a subdomain form an aggregate with
+ * one coarse unknown, which is constant on it. The coarse operator is the
+ * Galerkin product of these constants with the operator, a band matrix in the
+ * numbering of the process grid, and is factorized on every process. Each
+ * application gathers the sums of the residual over the aggregates of all
+ * processes, a few values per process.
+ *
+ * The preconditioner is symmetric positive definite and is used by PCG.
+ *
+ */
+class AdditiveSchwarz {
+  public:
+    AdditiveSchwarz() = default;
+
+    /**
+     * @brief Constructor of the preconditioner, factorizes the local and
+     * coarse operators
+     *
+     * @param[in] operator of the pressure equation
+     * @param[in] grid with the cell types of the subdomain and its ghost layer
+     */
+    AdditiveSchwarz(const PoissonOperator &op, const Grid &grid);
+
+    /**
+     * @brief Apply the preconditioner, z = M^-1 r
+     *
+     * @param[in] residual, zero outside the coupled fluid cells
+     * @param[out] preconditioned residual, zero in the ghost layer
+     */
+    void apply(const Matrix<double> &r, Matrix<double> &z);
+
+  private:
+    /// Storage index of each unknown of the local problem in the numbering of the factor
+    std::vector<int> _cells;
+    /// Aggregate of each coupled fluid cell of this process, -1 for all other cells
+    std::vector<int> _aggregate;
+    int _num_aggregates{0};
+    /// Global number of the first aggregate of this process and number of aggregates of every process
+    int _offset{0};
+    std::vector<int> _coarse_counts;
+    BandedCholesky _local;
+    BandedCholesky _coarse;
+
+    /// Residual with halo values and solution of the local problem
+    Matrix<double> _r_ext;
+    std::vector<double> _x;
+    /// Sums of the residual over the aggregates of this process and coarse solution of all processes
+    std::vector<double> _coarse_r;
+    std::vector<double> _coarse_x;
+};
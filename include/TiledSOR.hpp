@@ -0,0 +1,118 @@
+#pragma once
+
+#include <vector>
+
+#include "Datastructures.hpp"
+#include "PressureSolver.hpp"
+
+/**
+ * @brief Red-black SOR with temporal tiling of several sweeps
+ *
+ * Like MixedPrecisionSOR, an outer iterative refinement computes the residual
+ * of the pressure with the real boundary conditions, and the correction
+ * equation A e = r is relaxed by red-black SOR sweeps from e = 0, with the
+ * boundary conditions in the diagonal of PoissonOperator. As the sweeps never
+ * touch the boundaries, several of them are done per pass over the memory:
+ * the half-sweeps (one color each) run as a wavefront over the rows, where
+ * half-sweep h relaxes row t - h in step t. Only the rows between the leading
+ * and the trailing half-sweep are in use, which fit in the cache, so e, r and
+ * the diagonal are streamed from memory once per refinement instead of once per
+ * half-sweep. Every half-sweep sees the values of the previous one, so the
+ * result is the one of the untiled sweeps.
+ *
+ * With threads the rows are split into strips. Each strip runs its wavefront
+ * on a trapezoid that shrinks by one row per half-sweep at the edges towards
+ * the other strips, the remaining triangles at the strip edges are relaxed
+ * afterwards.
+ *
+ * The solver runs on a single process. Between processes the halo of the
+ * correction would have to be exchanged after every half-sweep, which leaves
+ * nothing to tile, so Case selects RedBlackSOR instead.
+ *
+ */
+class TiledSOR : public PressureSolver {
+  public:
+    TiledSOR() = default;
+
+    /**
+     * @brief Constructor of tiled SOR solver
+     *
+     * @param[in] relaxation factor
+     * @param[in] grid to take the cell types from
+     * @param[in] number of sweeps per refinement
+     */
+    TiledSOR(double omega, const Grid &grid, int sweeps);
+
+    virtual ~TiledSOR() = default;
+
+    /**
+     * @brief Perform one refinement step on the pressure equation
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     */
+    virtual double solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Refine the pressure until the residual is below the tolerance,
+     * counting the sweeps as iterations
+     *
+     * The residual is checked after every refinement.
+     *
+     * @param[in] field to be used
+     * @param[in] grid to be used
+     * @param[in] boundary to be used
+     * @param[in] tolerance of the residual
+     * @param[in] maximum number of iterations
+     * @param[out] number of performed iterations
+     */
+    virtual double solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                double tolerance, int max_iter, int &iter);
+
+  private:
+    /**
+     * @brief Store the residual of the pressure and clear the correction on the fluid spans
+     *
+     * @return sum of the squared residuals over the fluid cells of this process
+     */
+    double residual(Fields &field, const Grid &grid);
+
+    /// Relax the correction equation by the given number of sweeps with temporal tiling
+    void relax(int sweeps);
+
+    /// Add the correction to the pressure and update its boundaries
+    void update(Fields &field, const std::vector<std::unique_ptr<Boundary>> &boundaries);
+
+    /**
+     * @brief Relax the correction on the fluid cells of one color in a row
+     *
+     * @param[in] y index of the row
+     * @param[in] color, 0 or 1
+     */
+    void relax_row(int j, int color);
+
+    /// Fluid cell coupled to diagonal neighbours over wall corners, see PoissonOperator
+    struct LinkedCell {
+        int cell;
+        double inv_diag;
+        std::vector<int> neighbours;
+    };
+
+    double _omega{1.0};
+    int _sweeps{1};
+    double _idx2{1.0};
+    double _idy2{1.0};
+    /// Color of cell (i, j) is (i + j + _parity) % 2, consistent over all ranks
+    int _parity{0};
+    /// Inverse diagonal of the fluid cells without corner links, 0 otherwise
+    Matrix<double> _inv_diag;
+    /// Fluid cells with corner links in storage order, the ones of row j from _linked_start[j]
+    std::vector<LinkedCell> _linked;
+    std::vector<int> _linked_start;
+    double _corner_weight{0.0};
+    FluidSpans _spans;
+    /// Residual of the pressure and correction, zero outside the fluid spans
+    Matrix<double> _r;
+    Matrix<double> _e;
+};
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "AlgebraicMultigrid.hpp"
+#include "Communication.hpp"
+
+namespace {
+/// Strength of connection threshold, a_ij is strong if |a_ij| >= theta sqrt(a_ii a_jj)
+constexpr double strength_threshold = 0.08;
+/// Levels with at most this number of rows are solved directly
+constexpr int coarsest_size = 200;
+constexpr int max_levels = 25;
+
+/// Sparse matrix product C = A B (Gustavson)
+CSRMatrix multiply(const CSRMatrix &a, const CSRMatrix &b) {
+    CSRMatrix c;
+    c.rows = a.rows;
+    c.cols = b.cols;
+    c.row_start.reserve(a.rows + 1);
+    // Position of a column in the current row of C, below the row start if not present
+    std::vector<int> position(b.cols, -1);
+    for (int i = 0; i < a.rows; ++i) {
+        int row_begin = c.col.size();
+        for (int k = a.row_start[i]; k < a.row_start[i + 1]; ++k) {
+            int j = a.col[k];
+            for (int l = b.row_start[j]; l < b.row_start[j + 1]; ++l) {
+                int col = b.col[l];
+                if (position[col] < row_begin) {
+                    position[col] = c.col.size();
+                    c.col.push_back(col);
+                    c.value.push_back(a.value[k] * b.value[l]);
+                } else {
+                    c.value[position[col]] += a.value[k] * b.value[l];
+                }
+            }
+        }
+        c.row_start.push_back(c.col.size());
+    }
+    return c;
+}
+
+CSRMatrix transpose(const CSRMatrix &a) {
+    CSRMatrix t;
+    t.rows = a.cols;
+    t.cols = a.rows;
+    t.row_start.assign(a.cols + 1, 0);
+    for (int col : a.col) {
+        t.row_start[col + 1] += 1;
+    }
+    for (int i = 0; i < a.cols; ++i) {
+        t.row_start[i + 1] += t.row_start[i];
+    }
+    t.col.resize(a.nonzeros());
+    t.value.resize(a.nonzeros());
+    std::vector<int> next(t.row_start.begin(), t.row_start.end() - 1);
+    for (int i = 0; i < a.rows; ++i) {
+        for (int k = a.row_start[i]; k < a.row_start[i + 1]; ++k) {
+            int pos = next[a.col[k]]++;
+            t.col[pos] = i;
+            t.value[pos] = a.value[k];
+        }
+    }
+    return t;
+}
+} // namespace
+
+void CSRMatrix::multiply(const std::vector<double> &x, std::vector<double> &y) const {
+    for (int i = 0; i < rows; ++i) {
+        double sum = 0.0;
+        for (int k = row_start[i]; k < row_start[i + 1]; ++k) {
+            sum += value[k] * x[col[k]];
+        }
+        y[i] = sum;
+    }
+}
+
+AlgebraicMultigrid::AlgebraicMultigrid(const PoissonOperator &op, const Grid &grid) {
+    double start = MPI_Wtime();
+
+    // Rows of the coupled fluid cells, couplings to the ghost layer are dropped
+    int stride = op.mask().stride();
+    std::vector<int> index(op.mask().size(), -1);
+    for (const auto &cell : grid.fluid_cells()) {
+        int c = cell.j() * stride + cell.i();
+        if (op.mask().data()[c] > 0.0) {
+            index[c] = _cells.size();
+            _cells.push_back(c);
+        }
+    }
+    std::vector<std::vector<std::pair<int, double>>> links(_cells.size());
+    for (const auto &link : op.corner_links()) {
+        if (index[link.neighbour] >= 0) {
+            links[index[link.cell]].push_back({index[link.neighbour], -op.corner_weight()});
+        }
+    }
+
+    Level fine;
+    CSRMatrix &A = fine.A;
+    A.rows = _cells.size();
+    A.cols = A.rows;
+    const double *open_x = op.open_x().data();
+    const double *open_y = op.open_y().data();
+    for (std::size_t k = 0; k < _cells.size(); ++k) {
+        int c = _cells[k];
+        auto add = [&](int col, double value) {
+            A.col.push_back(col);
+            A.value.push_back(value);
+        };
+        add(k, op.diag().data()[c]);
+        const std::array<std::pair<int, double>, 4> faces{{{c - 1, open_x[c - 1] * op.idx2()},
+                                                          {c + 1, open_x[c] * op.idx2()},
+                                                          {c - stride, open_y[c - stride] * op.idy2()},
+                                                          {c + stride, open_y[c] * op.idy2()}}};
+        for (const auto &face : faces) {
+            if (face.second > 0.0 and index[face.first] >= 0) {
+                add(index[face.first], -face.second);
+            }
+        }
+        for (const auto &link : links[k]) {
+            add(link.first, link.second);
+        }
+        A.row_start.push_back(A.col.size());
+    }
+    _levels.push_back(std::move(fine));
+
+    while (static_cast<int>(_levels.size()) < max_levels and _levels.back().A.rows > coarsest_size and
+           coarsen(_levels.size() - 1)) {
+    }
+
+    for (auto &level : _levels) {
+        int n = level.A.rows;
+        level.inv_diag.assign(n, 0.0);
+        for (int i = 0; i < n; ++i) {
+            for (int k = level.A.row_start[i]; k < level.A.row_start[i + 1]; ++k) {
+                if (level.A.col[k] == i and level.A.value[k] != 0.0) {
+                    level.inv_diag[i] = 1.0 / level.A.value[k];
+                }
+            }
+        }
+        level.x.assign(n, 0.0);
+        level.b.assign(n, 0.0);
+        level.r.assign(n, 0.0);
+    }
+
+    // The coarsest matrix is small, its natural ordering is good enough for the band
+    const CSRMatrix &coarsest = _levels.back().A;
+    int bandwidth = 0;
+    for (int i = 0; i < coarsest.rows; ++i) {
+        for (int k = coarsest.row_start[i]; k < coarsest.row_start[i + 1]; ++k) {
+            bandwidth = std::max(bandwidth, i - coarsest.col[k]);
+        }
+    }
+    _coarse = BandedCholesky(coarsest.rows, bandwidth);
+    for (int i = 0; i < coarsest.rows; ++i) {
+        for (int k = coarsest.row_start[i]; k < coarsest.row_start[i + 1]; ++k) {
+            if (coarsest.col[k] <= i) {
+                _coarse.add(i, coarsest.col[k], coarsest.value[k]);
+            }
+        }
+    }
+    // The coarsest matrix of a subdomain without outflow is singular
+    _coarse.pin_singular_components();
+    _coarse.factorize();
+
+    double nonzeros = 0.0;
+    for (const auto &level : _levels) {
+        nonzeros += level.A.nonzeros();
+    }
+    double fine_nonzeros = Communication::reduce_sum(_levels[0].A.nonzeros());
+    double complexity = Communication::reduce_sum(nonzeros) / std::max(fine_nonzeros, 1.0);
+    double levels = Communication::reduce_max(_levels.size());
+    double setup_time = Communication::reduce_max(MPI_Wtime() - start);
+    int rank;
+    MPI_Comm_rank(MPI_COMMUNICATOR, &rank);
+    if (rank == 0) {
+        std::cout << "AMG setup: " << levels << " levels, operator complexity " << complexity << ", setup time "
+                  << setup_time << " s" << std::endl;
+    }
+}
+
+bool AlgebraicMultigrid::coarsen(int l) {
+    const CSRMatrix &A = _levels[l].A;
+    int n = A.rows;
+
+    std::vector<double> diag(n, 0.0);
+    for (int i = 0; i < n; ++i) {
+        for (int k = A.row_start[i]; k < A.row_start[i + 1]; ++k) {
+            if (A.col[k] == i) {
+                diag[i] = A.value[k];
+            }
+        }
+    }
+    auto strong = [&](int i, int k) {
+        int j = A.col[k];
+        return j != i and std::abs(A.value[k]) >= strength_threshold * std::sqrt(std::abs(diag[i] * diag[j]));
+    };
+
+    // Aggregation: 1. cells whose strong neighbours are all free form an
+    // aggregate with them, 2. free cells join the aggregate of their strongest
+    // neighbour, 3. the remaining cells form aggregates with their free neighbours
+    std::vector<int> aggregate(n, -1);
+    int num_aggregates = 0;
+    for (int i = 0; i < n; ++i) {
+        if (aggregate[i] >= 0) {
+            continue;
+        }
+        bool free = true;
+        for (int k = A.row_start[i]; k < A.row_start[i + 1] and free; ++k) {
+            free = not strong(i, k) or aggregate[A.col[k]] < 0;
+        }
+        if (not free) {
+            continue;
+        }
+        aggregate[i] = num_aggregates;
+        for (int k = A.row_start[i]; k < A.row_start[i + 1]; ++k) {
+            if (strong(i, k)) {
+                aggregate[A.col[k]] = num_aggregates;
+            }
+        }
+        num_aggregates += 1;
+    }
+    std::vector<int> first_pass(aggregate);
+    for (int i = 0; i < n; ++i) {
+        if (aggregate[i] >= 0) {
+            continue;
+        }
+        double strongest = 0.0;
+        for (int k = A.row_start[i]; k < A.row_start[i + 1]; ++k) {
+            if (strong(i, k) and first_pass[A.col[k]] >= 0 and std::abs(A.value[k]) > strongest) {
+                strongest = std::abs(A.value[k]);
+                aggregate[i] = first_pass[A.col[k]];
+            }
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        if (aggregate[i] >= 0) {
+            continue;
+        }
+        aggregate[i] = num_aggregates;
+        for (int k = A.row_start[i]; k < A.row_start[i + 1]; ++k) {
+            if (strong(i, k) and aggregate[A.col[k]] < 0) {
+                aggregate[A.col[k]] = num_aggregates;
+            }
+        }
+        num_aggregates += 1;
+    }
+    if (num_aggregates == n) {
+        return false;
+    }
+
+    // Tentative prolongation, the constants on the aggregates
+    CSRMatrix tentative;
+    tentative.rows = n;
+    tentative.cols = num_aggregates;
+    for (int i = 0; i < n; ++i) {
+        tentative.col.push_back(aggregate[i]);
+        tentative.value.push_back(1.0);
+        tentative.row_start.push_back(i + 1);
+    }
+
+    // Jacobi smoothing P = (I - omega D^-1 A) P_tent, omega = 4 / (3 rho) with
+    // the Gershgorin bound rho of the spectral radius of D^-1 A
+    double rho = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double sum = 0.0;
+        for (int k = A.row_start[i]; k < A.row_start[i + 1]; ++k) {
+            sum += std::abs(A.value[k]);
+        }
+        rho = std::max(rho, sum / diag[i]);
+    }
+    double omega = 4.0 / (3.0 * rho);
+    CSRMatrix smoother = A;
+    for (int i = 0; i < n; ++i) {
+        for (int k = smoother.row_start[i]; k < smoother.row_start[i + 1]; ++k) {
+            smoother.value[k] = (smoother.col[k] == i ? 1.0 : 0.0) - omega * A.value[k] / diag[i];
+        }
+    }
+
+    Level coarse;
+    _levels[l].P = multiply(smoother, tentative);
+    _levels[l].R = transpose(_levels[l].P);
+    coarse.A = multiply(multiply(_levels[l].R, _levels[l].A), _levels[l].P);
+    _levels.push_back(std::move(coarse));
+    return true;
+}
+
+void AlgebraicMultigrid::apply(const Matrix<double> &r, Matrix<double> &z) {
+    Level &fine = _levels[0];
+    const double *r_data = r.data();
+    for (std::size_t k = 0; k < _cells.size(); ++k) {
+        fine.b[k] = r_data[_cells[k]];
+    }
+
+    cycle(0);
+
+    double *z_data = z.data();
+    std::fill(z_data, z_data + z.size(), 0.0);
+    for (std::size_t k = 0; k < _cells.size(); ++k) {
+        z_data[_cells[k]] = fine.x[k];
+    }
+}
+
+void AlgebraicMultigrid::cycle(int l) {
+    Level &level = _levels[l];
+    if (l == static_cast<int>(_levels.size()) - 1) {
+        level.x = level.b;
+        _coarse.solve(level.x);
+        return;
+    }
+
+    std::fill(level.x.begin(), level.x.end(), 0.0);
+    sweep(level, true);
+
+    level.A.multiply(level.x, level.r);
+    for (int i = 0; i < level.A.rows; ++i) {
+        level.r[i] = level.b[i] - level.r[i];
+    }
+    Level &coarse = _levels[l + 1];
+    level.R.multiply(level.r, coarse.b);
+    cycle(l + 1);
+    level.P.multiply(coarse.x, level.r);
+    for (int i = 0; i < level.A.rows; ++i) {
+        level.x[i] += level.r[i];
+    }
+
+    sweep(level, false);
+}
+
+void AlgebraicMultigrid::sweep(Level &level, bool forward) {
+    const CSRMatrix &A = level.A;
+    int n = A.rows;
+    for (int step = 0; step < n; ++step) {
+        int i = forward ? step : n - 1 - step;
+        double sum = level.b[i];
+        for (int k = A.row_start[i]; k < A.row_start[i + 1]; ++k) {
+            sum -= A.value[k] * level.x[A.col[k]];
+        }
+        level.x[i] += level.inv_diag[i] * sum;
+    }
+}
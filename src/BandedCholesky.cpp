@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+
+#include "BandedCholesky.hpp"
+
+BandedCholesky::BandedCholesky(int size, int bandwidth)
+    : _size(size), _bandwidth(bandwidth), _band(static_cast<std::size_t>(size) * (bandwidth + 1), 0.0) {}
+
+void BandedCholesky::add(int row, int col, double value) { entry(row, col) += value; }
+
+int BandedCholesky::pin_singular_components() {
+    // Relative size of a row sum below which it is taken as zero
+    constexpr double row_sum_tolerance = 1e-10;
+
+    std::vector<double> row_sum(_size, 0.0);
+    for (int i = 0; i < _size; ++i) {
+        for (int k = std::max(0, i - _bandwidth); k <= i; ++k) {
+            row_sum[i] += entry(i, k);
+            if (k < i) {
+                row_sum[k] += entry(i, k);
+            }
+        }
+    }
+
+    // Components of the graph of the off-diagonal entries, by depth-first search
+    std::vector<char> visited(_size, 0);
+    std::vector<int> stack;
+    _components.clear();
+    for (int start = 0; start < _size; ++start) {
+        if (visited[start]) {
+            continue;
+        }
+        std::vector<int> component;
+        bool singular = true;
+        visited[start] = 1;
+        stack.push_back(start);
+        while (not stack.empty()) {
+            int i = stack.back();
+            stack.pop_back();
+            component.push_back(i);
+            singular = singular and entry(i, i) > 0.0 and std::abs(row_sum[i]) <= row_sum_tolerance * entry(i, i);
+            int first = std::max(0, i - _bandwidth);
+            int last = std::min(_size - 1, i + _bandwidth);
+            for (int k = first; k <= last; ++k) {
+                double value = k < i ? entry(i, k) : entry(k, i);
+                if (k != i and value != 0.0 and not visited[k]) {
+                    visited[k] = 1;
+                    stack.push_back(k);
+                }
+            }
+        }
+        if (singular) {
+            std::sort(component.begin(), component.end());
+            _components.push_back(std::move(component));
+        }
+    }
+
+    for (const auto &component : _components) {
+        int p = component.front();
+        for (int k = std::max(0, p - _bandwidth); k < p; ++k) {
+            entry(p, k) = 0.0;
+        }
+        for (int k = p + 1; k <= std::min(_size - 1, p + _bandwidth); ++k) {
+            entry(k, p) = 0.0;
+        }
+        entry(p, p) = 1.0;
+    }
+    return _components.size();
+}
+
+int BandedCholesky::factorize() {
+    // Relative size of a pivot below which it is taken as zero
+    constexpr double pivot_tolerance = 1e-10;
+
+    int pinned = 0;
+    for (int j = 0; j < _size; ++j) {
+        int first = std::max(0, j - _bandwidth);
+
+        double diag = entry(j, j);
+        double pivot = diag;
+        for (int k = first; k < j; ++k) {
+            pivot -= entry(j, k) * entry(j, k);
+        }
+        if (pivot <= pivot_tolerance * diag) {
+            pivot = diag > 0.0 ? diag : 1.0;
+            pinned += 1;
+        }
+        double l_jj = std::sqrt(pivot);
+        entry(j, j) = l_jj;
+
+        int last = std::min(_size - 1, j + _bandwidth);
+        for (int i = j + 1; i <= last; ++i) {
+            double value = entry(i, j);
+            for (int k = std::max(first, i - _bandwidth); k < j; ++k) {
+                value -= entry(i, k) * entry(j, k);
+            }
+            entry(i, j) = value / l_jj;
+        }
+    }
+    return pinned;
+}
+
+void BandedCholesky::solve(std::vector<double> &x) const {
+    // Only the part of the right hand side with zero mean can be matched on a
+    // singular component
+    for (const auto &component : _components) {
+        double mean = 0.0;
+        for (int k : component) {
+            mean += x[k];
+        }
+        mean /= component.size();
+        for (int k : component) {
+            x[k] -= mean;
+        }
+        x[component.front()] = 0.0;
+    }
+    // forward substitution with L
+    for (int i = 0; i < _size; ++i) {
+        double value = x[i];
+        for (int k = std::max(0, i - _bandwidth); k < i; ++k) {
+            value -= entry(i, k) * x[k];
+        }
+        x[i] = value / entry(i, i);
+    }
+    // backward substitution with L^T
+    for (int i = _size - 1; i >= 0; --i) {
+        double value = x[i] / entry(i, i);
+        x[i] = value;
+        for (int k = std::max(0, i - _bandwidth); k < i; ++k) {
+            x[k] -= entry(i, k) * value;
+        }
+    }
+}
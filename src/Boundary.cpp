@@ -1,411 +1,453 @@
 #include "Boundary.hpp"
 
-Boundary::Boundary(std::vector<Cell *> cells) : _cells(cells) {}
+#include <stdexcept>
+#include <string>
+
+bool BoundaryTable::keep(int index) const {
+    if (index == outside) {
+        return false;
+    }
+#ifdef FLUIDCHEN_BOUNDS_CHECK
+    if (index < 0 or index >= _size) {
+        throw std::out_of_range("Boundary table index " + std::to_string(index) + " out of range " +
+                                std::to_string(_size));
+    }
+    return true;
+#else
+    return index >= 0 and index < _size;
+#endif
+}
+
+void BoundaryTable::add(int target, int source, double weight, double constant) {
+    if (keep(target) and keep(source)) {
+        _entries.push_back({target, {source, source}, {weight, 0.0}, constant});
+    }
+}
+
+void BoundaryTable::add(int target, int source0, double weight0, int source1, double weight1) {
+    if (keep(target) and keep(source0) and keep(source1)) {
+        _entries.push_back({target, {source0, source1}, {weight0, weight1}, 0.0});
+    }
+}
+
+template <typename T> void BoundaryTable::apply(const Matrix<T> &source, Matrix<T> &target) const {
+    const T *s = source.data();
+    T *t = target.data();
+    for (const auto &e : _entries) {
+#ifdef FLUIDCHEN_BOUNDS_CHECK
+        if (e.target >= target.size() or e.source[0] >= source.size() or e.source[1] >= source.size()) {
+            throw std::out_of_range("Boundary table index " + std::to_string(e.target) + " out of range " +
+                                    std::to_string(target.size()));
+        }
+#endif
+        t[e.target] = static_cast<T>(e.weight[0] * s[e.source[0]] + e.weight[1] * s[e.source[1]] + e.constant);
+    }
+}
+
+template void BoundaryTable::apply(const Matrix<double> &source, Matrix<double> &target) const;
+template void BoundaryTable::apply(const Matrix<float> &source, Matrix<float> &target) const;
+
+void BoundaryTable::reset(int size) {
+    _entries.clear();
+    _size = size;
+}
+
+Boundary::Boundary(std::vector<Cell> cells) : _cells(cells) {}
+
+int Boundary::at(int i, int j) const {
+    if (i < 0 or j < 0 or i >= _num_cols or j >= _num_rows) {
+        return BoundaryTable::outside;
+    }
+    return j * _stride + i;
+}
+
+template <typename T> void Boundary::prepare(const Matrix<T> &field) {
+    if (field.stride() == _stride and field.num_cols() == _num_cols and field.num_rows() == _num_rows) {
+        return;
+    }
+    _stride = field.stride();
+    _num_cols = field.num_cols();
+    _num_rows = field.num_rows();
+    for (auto *table : {&_u_table, &_v_table, &_p_table, &_f_table, &_g_table, &_t_table}) {
+        table->reset(field.size());
+    }
+    build_tables();
+}
+
+void Boundary::applyVelocity(Fields &field) {
+    prepare(field.u_matrix());
+    _u_table.apply(field.u_matrix(), field.u_matrix());
+    _v_table.apply(field.v_matrix(), field.v_matrix());
+}
+
+void Boundary::applyPressure(Fields &field) {
+    prepare(field.p_matrix());
+    _p_table.apply(field.p_matrix(), field.p_matrix());
+}
+
 void Boundary::applyFlux(Fields &field) {
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
+    prepare(field.f_matrix());
+    _f_table.apply(field.u_matrix(), field.f_matrix());
+    _g_table.apply(field.v_matrix(), field.g_matrix());
+}
+
+void Boundary::applyTemperature(Fields &field) {
+    prepare(field.t_matrix());
+    _t_table.apply(field.t_matrix(), field.t_matrix());
+}
+
+void Boundary::build_tables() {
+    for (const auto &cell : _cells) {
+        int i = cell.i();
+        int j = cell.j();
 
         // B_NW cell
-        if (cell->is_border(border_position::TOP) && cell->is_border(border_position::LEFT)) {
-            field.f(i - 1, j) = field.u(i - 1, j);
-            field.g(i, j) = field.v(i, j);
+        if (cell.is_border(border_position::TOP) && cell.is_border(border_position::LEFT)) {
+            _f_table.add(at(i - 1, j), at(i - 1, j), 1.0);
+            _g_table.add(at(i, j), at(i, j), 1.0);
             continue;
         }
         // B_SE cell
-        if (cell->is_border(border_position::BOTTOM) && cell->is_border(border_position::RIGHT)) {
-            field.f(i, j) = field.u(i, j);
-            field.g(i, j - 1) = field.v(i, j - 1);
+        if (cell.is_border(border_position::BOTTOM) && cell.is_border(border_position::RIGHT)) {
+            _f_table.add(at(i, j), at(i, j), 1.0);
+            _g_table.add(at(i, j - 1), at(i, j - 1), 1.0);
             continue;
         }
         // B_NE cell
-        if (cell->is_border(border_position::TOP) && cell->is_border(border_position::RIGHT)) {
-            field.f(i, j) = field.u(i, j);
-            field.g(i, j) = field.v(i, j);
+        if (cell.is_border(border_position::TOP) && cell.is_border(border_position::RIGHT)) {
+            _f_table.add(at(i, j), at(i, j), 1.0);
+            _g_table.add(at(i, j), at(i, j), 1.0);
             continue;
         }
         // B_SW cell
-        if (cell->is_border(border_position::BOTTOM) && cell->is_border(border_position::LEFT)) {
-            field.f(i, j) = field.u(i - 1, j);
-            field.g(i, j - 1) = field.v(i, j - 1);
+        if (cell.is_border(border_position::BOTTOM) && cell.is_border(border_position::LEFT)) {
+            _f_table.add(at(i, j), at(i - 1, j), 1.0);
+            _g_table.add(at(i, j - 1), at(i, j - 1), 1.0);
             continue;
         }
 
-        if (cell->is_border(border_position::RIGHT)) {
-            field.f(i, j) = field.u(i, j);
+        if (cell.is_border(border_position::RIGHT)) {
+            _f_table.add(at(i, j), at(i, j), 1.0);
         }
-        if (cell->is_border(border_position::LEFT)) {
-            field.f(i - 1, j) = field.u(i - 1, j);
+        if (cell.is_border(border_position::LEFT)) {
+            _f_table.add(at(i - 1, j), at(i - 1, j), 1.0);
         }
-        if (cell->is_border(border_position::TOP)) {
-            field.g(i, j) = field.v(i, j);
+        if (cell.is_border(border_position::TOP)) {
+            _g_table.add(at(i, j), at(i, j), 1.0);
         }
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.g(i, j - 1) = field.v(i, j - 1);
+        if (cell.is_border(border_position::BOTTOM)) {
+            _g_table.add(at(i, j - 1), at(i, j - 1), 1.0);
         }
     }
 }
-void Boundary::applyTemperature(Fields &field) {}
 
-InnerObstacle::InnerObstacle(std::vector<Cell *> cells) : Boundary(cells) {}
-void InnerObstacle::applyVelocity(Fields &field) {
-    for (auto cell: _cells) {
-        int i = cell->i();
-        int j = cell->j();
+InnerObstacle::InnerObstacle(std::vector<Cell> cells) : Boundary(cells) {}
 
-        field.u(i,j) = 0;
-        field.v(i,j) = 0;
+void InnerObstacle::build_tables() {
+    for (const auto &cell : _cells) {
+        int c = at(cell.i(), cell.j());
+        _u_table.add(c, c, 0.0);
+        _v_table.add(c, c, 0.0);
     }
-} // do nothing
-void InnerObstacle::applyFlux(Fields &field) {}
-void InnerObstacle::applyPressure(Fields &field) {}
-
-FixedWallBoundary::FixedWallBoundary(std::vector<Cell *> cells) : Boundary(cells) {}
+}
 
+FixedWallBoundary::FixedWallBoundary(std::vector<Cell> cells) : Boundary(cells) {}
 
-FixedWallBoundary::FixedWallBoundary(std::vector<Cell *> cells, double wall_temperature)
+FixedWallBoundary::FixedWallBoundary(std::vector<Cell> cells, double wall_temperature)
     : Boundary(cells), _wall_temperature(wall_temperature) {}
 
-void FixedWallBoundary::applyVelocity(Fields &field) {
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
+void FixedWallBoundary::build_tables() {
+    Boundary::build_tables();
 
-        // B_NW cell
-        if (cell->is_border(border_position::TOP) && cell->is_border(border_position::LEFT)) {
-            field.u(i - 1, j) = 0;
-            field.v(i, j) = 0;
-            field.u(i, j) = -field.u(i, j+1);
-            field.v(i, j-1) = - field.v(i-1, j-1);
+    // Velocity
+    for (const auto &cell : _cells) {
+        int i = cell.i();
+        int j = cell.j();
 
+        // B_NW cell
+        if (cell.is_border(border_position::TOP) && cell.is_border(border_position::LEFT)) {
+            _u_table.add(at(i - 1, j), at(i - 1, j), 0.0);
+            _v_table.add(at(i, j), at(i, j), 0.0);
+            _u_table.add(at(i, j), at(i, j + 1), -1.0);
+            _v_table.add(at(i, j - 1), at(i - 1, j - 1), -1.0);
             continue;
         }
         // B_SE cell
-        if (cell->is_border(border_position::BOTTOM) && cell->is_border(border_position::RIGHT)) {
-            field.u(i, j) = 0;
-            field.v(i, j-1) = 0;
-            field.u(i-1, j) = -field.u(i-1, j-1);
-            field.v(i, j) = -field.v(i+1, j);
-
+        if (cell.is_border(border_position::BOTTOM) && cell.is_border(border_position::RIGHT)) {
+            _u_table.add(at(i, j), at(i, j), 0.0);
+            _v_table.add(at(i, j - 1), at(i, j - 1), 0.0);
+            _u_table.add(at(i - 1, j), at(i - 1, j - 1), -1.0);
+            _v_table.add(at(i, j), at(i + 1, j), -1.0);
             continue;
         }
         // B_NE cell
-        if (cell->is_border(border_position::TOP) && cell->is_border(border_position::RIGHT)) {
-            field.u(i, j) = 0;
-            field.v(i, j) = 0;
-            field.u(i-1, j) = -field.u(i-1, j+1);
-            field.v(i, j-1) = - field.v(i+1, j-1);
-
+        if (cell.is_border(border_position::TOP) && cell.is_border(border_position::RIGHT)) {
+            _u_table.add(at(i, j), at(i, j), 0.0);
+            _v_table.add(at(i, j), at(i, j), 0.0);
+            _u_table.add(at(i - 1, j), at(i - 1, j + 1), -1.0);
+            _v_table.add(at(i, j - 1), at(i + 1, j - 1), -1.0);
             continue;
         }
         // B_SW cell
-        if (cell->is_border(border_position::BOTTOM) && cell->is_border(border_position::LEFT)) {
-            field.u(i-1, j) = 0;
-            field.v(i, j-1) = 0;
-            field.u(i, j) = -field.u(i, j-1);
-            field.v(i,j) = -field.v(i-1, j);
-
+        if (cell.is_border(border_position::BOTTOM) && cell.is_border(border_position::LEFT)) {
+            _u_table.add(at(i - 1, j), at(i - 1, j), 0.0);
+            _v_table.add(at(i, j - 1), at(i, j - 1), 0.0);
+            _u_table.add(at(i, j), at(i, j - 1), -1.0);
+            _v_table.add(at(i, j), at(i - 1, j), -1.0);
             continue;
         }
 
-         // B_E cell
-         if (cell->is_border(border_position::RIGHT)) {
-             field.v(i, j) = -field.v(i + 1, j);
-             field.u(i, j) = 0;
-         }
-         // B_W cell
-         if (cell->is_border(border_position::LEFT)) {
-             field.v(i, j) = -field.v(i - 1, j);
-             field.u(i - 1, j) = 0;
-         }
-         // B_N cell
-         if (cell->is_border(border_position::TOP)) {
-             field.u(i, j) = -field.u(i, j + 1);
-             field.v(i, j) = 0;
-         }
-         // B_S cell
-         if (cell->is_border(border_position::BOTTOM)) {
-             field.u(i, j) = -field.u(i, j - 1);
-             field.v(i, j - 1) = 0;
-         }
+        // B_E cell
+        if (cell.is_border(border_position::RIGHT)) {
+            _v_table.add(at(i, j), at(i + 1, j), -1.0);
+            _u_table.add(at(i, j), at(i, j), 0.0);
+        }
+        // B_W cell
+        if (cell.is_border(border_position::LEFT)) {
+            _v_table.add(at(i, j), at(i - 1, j), -1.0);
+            _u_table.add(at(i - 1, j), at(i - 1, j), 0.0);
+        }
+        // B_N cell
+        if (cell.is_border(border_position::TOP)) {
+            _u_table.add(at(i, j), at(i, j + 1), -1.0);
+            _v_table.add(at(i, j), at(i, j), 0.0);
+        }
+        // B_S cell
+        if (cell.is_border(border_position::BOTTOM)) {
+            _u_table.add(at(i, j), at(i, j - 1), -1.0);
+            _v_table.add(at(i, j - 1), at(i, j - 1), 0.0);
+        }
 
         // forbidden cells with two opposite borders or three boundaries
-        if (cell->is_border(border_position::BOTTOM) && cell->is_border(border_position::TOP)) {
+        if (cell.is_border(border_position::BOTTOM) && cell.is_border(border_position::TOP)) {
             std::cerr << "there are forbidden cells with two opposite borders or three boundaries \n";
             std::cerr << "i: " << i << " j: " << j << std::endl;
             exit(1);
         }
-        if (cell->is_border(border_position::LEFT) && cell->is_border(border_position::RIGHT)) {
+        if (cell.is_border(border_position::LEFT) && cell.is_border(border_position::RIGHT)) {
             std::cerr << "there are forbidden cells with two opposite borders or three boundaries \n";
             std::cerr << "i: " << i << " j: " << j << std::endl;
             exit(1);
         }
-        // forbidden cells with obstacles only consisting of 1 cell
-        if (cell->is_border(border_position::LEFT) && cell->is_border(border_position::RIGHT) &&
-            cell->is_border(border_position::TOP) && cell->is_border(border_position::BOTTOM)) {
-            std::cerr << "there are forbidden cells with four boundaries \n";
-            std::cerr << "i: " << i << " j: " << j << std::endl;
-            exit(1);
-        }
     }
-}
 
-void FixedWallBoundary::applyTemperature(Fields &field) {
+    // Temperature
+    for (const auto &cell : _cells) {
+        int i = cell.i();
+        int j = cell.j();
 
-    if (_wall_temperature == -1) { // Neumann
-        for (auto cell : _cells) {
-            int i = cell->i();
-            int j = cell->j();
-
-            if (cell->is_border(border_position::RIGHT)) {
-                field.T(i, j) = field.T(i + 1, j);
+        if (_wall_temperature == -1) { // Neumann
+            if (cell.is_border(border_position::RIGHT)) {
+                _t_table.add(at(i, j), at(i + 1, j), 1.0);
             }
-
-            if (cell->is_border(border_position::LEFT)) {
-                field.T(i, j) = field.T(i - 1, j);
+            if (cell.is_border(border_position::LEFT)) {
+                _t_table.add(at(i, j), at(i - 1, j), 1.0);
             }
-
-            if (cell->is_border(border_position::TOP)) {
-                field.T(i, j) = field.T(i, j + 1);
+            if (cell.is_border(border_position::TOP)) {
+                _t_table.add(at(i, j), at(i, j + 1), 1.0);
             }
-
-            if (cell->is_border(border_position::BOTTOM)) {
-                field.T(i, j) = field.T(i, j - 1);
+            if (cell.is_border(border_position::BOTTOM)) {
+                _t_table.add(at(i, j), at(i, j - 1), 1.0);
             }
-        }
-    } else { // Dirichlet
-
-        for (auto cell : _cells) {
-            int i = cell->i();
-            int j = cell->j();
-
-            if (cell->is_border(border_position::BOTTOM)) {
-                field.T(i, j) = 2 * _wall_temperature - field.T(i, j - 1);
+        } else { // Dirichlet
+            if (cell.is_border(border_position::BOTTOM)) {
+                _t_table.add(at(i, j), at(i, j - 1), -1.0, 2 * _wall_temperature);
             }
-            if (cell->is_border(border_position::TOP)) {
-                field.T(i, j) = 2 * _wall_temperature - field.T(i, j + 1);
+            if (cell.is_border(border_position::TOP)) {
+                _t_table.add(at(i, j), at(i, j + 1), -1.0, 2 * _wall_temperature);
             }
-
-            if (cell->is_border(border_position::RIGHT)) {
-                field.T(i, j) = 2 * _wall_temperature - field.T(i + 1, j);
+            if (cell.is_border(border_position::RIGHT)) {
+                _t_table.add(at(i, j), at(i + 1, j), -1.0, 2 * _wall_temperature);
             }
-
-            if (cell->is_border(border_position::LEFT)) {
-                field.T(i, j) = 2 * _wall_temperature - field.T(i - 1, j);
+            if (cell.is_border(border_position::LEFT)) {
+                _t_table.add(at(i, j), at(i - 1, j), -1.0, 2 * _wall_temperature);
             }
         }
     }
-}
 
-void FixedWallBoundary::applyPressure(Fields &field) {
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
+    // Pressure
+    for (const auto &cell : _cells) {
+        int i = cell.i();
+        int j = cell.j();
 
-        if (cell->is_border(border_position::RIGHT)) {
-            field.p(i, j) = field.p(i + 1, j); // i = 0
+        if (cell.is_border(border_position::RIGHT)) {
+            _p_table.add(at(i, j), at(i + 1, j), 1.0); // i = 0
         }
-
-        if (cell->is_border(border_position::LEFT)) {
-            field.p(i, j) = field.p(i - 1, j); // i = imax + 1
+        if (cell.is_border(border_position::LEFT)) {
+            _p_table.add(at(i, j), at(i - 1, j), 1.0); // i = imax + 1
         }
-
-        if (cell->is_border(border_position::TOP)) {
-            field.p(i, j) = field.p(i, j + 1); // j = 0
+        if (cell.is_border(border_position::TOP)) {
+            _p_table.add(at(i, j), at(i, j + 1), 1.0); // j = 0
         }
-
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.p(i, j) = field.p(i, j - 1); // j = jmax + 1
+        if (cell.is_border(border_position::BOTTOM)) {
+            _p_table.add(at(i, j), at(i, j - 1), 1.0); // j = jmax + 1
         }
 
         // B_NW cell
-        if (cell->is_border(border_position::TOP) && cell->is_border(border_position::LEFT)) {
-            field.p(i, j) = (field.p(i, j + 1) + field.p(i - 1, j)) / 2;
+        if (cell.is_border(border_position::TOP) && cell.is_border(border_position::LEFT)) {
+            _p_table.add(at(i, j), at(i, j + 1), 0.5, at(i - 1, j), 0.5);
         }
         // B_SE cell
-        if (cell->is_border(border_position::BOTTOM) && cell->is_border(border_position::RIGHT)) {
-            field.p(i, j) = (field.p(i + 1, j) + field.p(i, j - 1)) / 2;
+        if (cell.is_border(border_position::BOTTOM) && cell.is_border(border_position::RIGHT)) {
+            _p_table.add(at(i, j), at(i + 1, j), 0.5, at(i, j - 1), 0.5);
         }
         // B_SW cell
-        if (cell->is_border(border_position::BOTTOM) && cell->is_border(border_position::LEFT)) {
-            field.p(i, j) = (field.p(i - 1, j) + field.p(i, j - 1)) / 2;
+        if (cell.is_border(border_position::BOTTOM) && cell.is_border(border_position::LEFT)) {
+            _p_table.add(at(i, j), at(i - 1, j), 0.5, at(i, j - 1), 0.5);
         }
         // B_NE cell
-        if (cell->is_border(border_position::TOP) && cell->is_border(border_position::RIGHT)) {
-            field.p(i, j) = (field.p(i, j + 1) + field.p(i + 1, j)) / 2;
+        if (cell.is_border(border_position::TOP) && cell.is_border(border_position::RIGHT)) {
+            _p_table.add(at(i, j), at(i, j + 1), 0.5, at(i + 1, j), 0.5);
         }
     }
 }
-FixedVelocityBoundary::FixedVelocityBoundary(std::vector<Cell *> cells, double inflow_u_velocity,
+
+FixedVelocityBoundary::FixedVelocityBoundary(std::vector<Cell> cells, double inflow_u_velocity,
                                              double inflow_v_velocity)
     : Boundary(cells) {
     _inflow_u_velocity.insert(std::pair<int, double>(GeometryIDs::fixed_velocity, inflow_u_velocity));
     _inflow_v_velocity.insert(std::pair<int, double>(GeometryIDs::fixed_velocity, inflow_v_velocity));
 }
 
-FixedVelocityBoundary::FixedVelocityBoundary(std::vector<Cell *> cells, std::map<int, double> inflow_u_velocity,
+FixedVelocityBoundary::FixedVelocityBoundary(std::vector<Cell> cells, std::map<int, double> inflow_u_velocity,
                                              std::map<int, double> inflow_v_velocity,
                                              std::map<int, double> wall_temperature)
     : Boundary(cells), _inflow_u_velocity(inflow_u_velocity), _inflow_v_velocity(inflow_v_velocity),
       _wall_temperature(wall_temperature) {}
 
-void FixedVelocityBoundary::applyVelocity(Fields &field) {
+void FixedVelocityBoundary::build_tables() {
+    Boundary::build_tables();
+    double u_in = _inflow_u_velocity[GeometryIDs::fixed_velocity];
+    double v_in = _inflow_v_velocity[GeometryIDs::fixed_velocity];
 
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
+    for (const auto &cell : _cells) {
+        int i = cell.i();
+        int j = cell.j();
 
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.u(i, j) = 2 * _inflow_u_velocity[GeometryIDs::fixed_velocity] - field.u(i, j - 1);
-            field.v(i, j - 1) = _inflow_v_velocity[GeometryIDs::fixed_velocity];
+        if (cell.is_border(border_position::BOTTOM)) {
+            _u_table.add(at(i, j), at(i, j - 1), -1.0, 2 * u_in);
+            _v_table.add(at(i, j - 1), at(i, j - 1), 0.0, v_in);
         }
-        if (cell->is_border(border_position::TOP)) {
-            field.u(i, j) = 2 * _inflow_u_velocity[GeometryIDs::fixed_velocity] - field.u(i, j + 1);
-            field.v(i, j) = _inflow_v_velocity[GeometryIDs::fixed_velocity];
+        if (cell.is_border(border_position::TOP)) {
+            _u_table.add(at(i, j), at(i, j + 1), -1.0, 2 * u_in);
+            _v_table.add(at(i, j), at(i, j), 0.0, v_in);
         }
-
-        if (cell->is_border(border_position::RIGHT)) {
-            field.u(i, j) = _inflow_u_velocity[GeometryIDs::fixed_velocity];
-            field.v(i, j) = 2 * _inflow_v_velocity[GeometryIDs::fixed_velocity] - field.v(i + 1, j);
+        if (cell.is_border(border_position::RIGHT)) {
+            _u_table.add(at(i, j), at(i, j), 0.0, u_in);
+            _v_table.add(at(i, j), at(i + 1, j), -1.0, 2 * v_in);
         }
-
-        if (cell->is_border(border_position::LEFT)) {
-            field.u(i - 1, j) = _inflow_u_velocity[GeometryIDs::fixed_velocity];
-            field.v(i, j) = 2 * _inflow_v_velocity[GeometryIDs::fixed_velocity] - field.v(i - 1, j);
+        if (cell.is_border(border_position::LEFT)) {
+            _u_table.add(at(i - 1, j), at(i - 1, j), 0.0, u_in);
+            _v_table.add(at(i, j), at(i - 1, j), -1.0, 2 * v_in);
         }
-    }
-}
-void FixedVelocityBoundary::applyPressure(Fields &field) {
-    // Neumann condition
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
 
-        if (cell->is_border(border_position::RIGHT)) {
-            field.p(i, j) = field.p(i + 1, j);
+        // Neumann condition for the pressure
+        if (cell.is_border(border_position::RIGHT)) {
+            _p_table.add(at(i, j), at(i + 1, j), 1.0);
         }
-
-        if (cell->is_border(border_position::LEFT)) {
-            field.p(i, j) = field.p(i - 1, j);
+        if (cell.is_border(border_position::LEFT)) {
+            _p_table.add(at(i, j), at(i - 1, j), 1.0);
         }
-
-        if (cell->is_border(border_position::TOP)) {
-            field.p(i, j) = field.p(i, j + 1);
+        if (cell.is_border(border_position::TOP)) {
+            _p_table.add(at(i, j), at(i, j + 1), 1.0);
         }
-
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.p(i, j) = field.p(i, j - 1);
+        if (cell.is_border(border_position::BOTTOM)) {
+            _p_table.add(at(i, j), at(i, j - 1), 1.0);
         }
     }
 }
-ZeroGradientBoundary::ZeroGradientBoundary(std::vector<Cell *> cells) : Boundary(cells) {}
-ZeroGradientBoundary::ZeroGradientBoundary(std::vector<Cell *> cells, std::map<int, double> wall_temperature)
+
+ZeroGradientBoundary::ZeroGradientBoundary(std::vector<Cell> cells) : Boundary(cells) {}
+ZeroGradientBoundary::ZeroGradientBoundary(std::vector<Cell> cells, std::map<int, double> wall_temperature)
     : Boundary(cells), _wall_temperature(wall_temperature) {}
-void ZeroGradientBoundary::applyVelocity(Fields &field) {
-    // Neumann condition !!! CHange needed
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
 
-        if (cell->is_border(border_position::RIGHT)) {
-            field.u(i, j) = field.u(i + 1, j);
-            field.v(i, j) = field.v(i + 1, j);
-        }
+void ZeroGradientBoundary::build_tables() {
+    Boundary::build_tables();
 
-        if (cell->is_border(border_position::LEFT)) {
-            field.u(i, j) = field.u(i - 2, j);
-            field.u(i - 1, j) = field.u(i, j);
-            field.v(i, j) = field.v(i - 1, j);
-        }
+    for (const auto &cell : _cells) {
+        int i = cell.i();
+        int j = cell.j();
 
-        if (cell->is_border(border_position::TOP)) {
-            field.v(i, j) = field.v(i, j + 1);
-            field.u(i, j) = field.u(i, j + 1);
+        // Neumann condition for the velocities
+        if (cell.is_border(border_position::RIGHT)) {
+            _u_table.add(at(i, j), at(i + 1, j), 1.0);
+            _v_table.add(at(i, j), at(i + 1, j), 1.0);
         }
-
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.v(i, j) = field.v(i, j - 2);
-            field.v(i, j -1) = field.v(i, j);
-            field.u(i, j) = field.u(i, j -1);
+        if (cell.is_border(border_position::LEFT)) {
+            _u_table.add(at(i, j), at(i - 2, j), 1.0);
+            _u_table.add(at(i - 1, j), at(i, j), 1.0);
+            _v_table.add(at(i, j), at(i - 1, j), 1.0);
         }
-    }
-}
-void ZeroGradientBoundary::applyPressure(Fields &field) {
-    // Dirichlet condition pressure on boundary = 0
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
-
-        if (cell->is_border(border_position::RIGHT)) {
-            field.p(i, j) = -field.p(i + 1, j);
+        if (cell.is_border(border_position::TOP)) {
+            _v_table.add(at(i, j), at(i, j + 1), 1.0);
+            _u_table.add(at(i, j), at(i, j + 1), 1.0);
         }
-
-        if (cell->is_border(border_position::LEFT)) {
-            field.p(i, j) = -field.p(i - 1, j);
+        if (cell.is_border(border_position::BOTTOM)) {
+            _v_table.add(at(i, j), at(i, j - 2), 1.0);
+            _v_table.add(at(i, j - 1), at(i, j), 1.0);
+            _u_table.add(at(i, j), at(i, j - 1), 1.0);
         }
 
-        if (cell->is_border(border_position::TOP)) {
-            field.p(i, j) = -field.p(i, j + 1);
+        // Dirichlet condition pressure on boundary = 0
+        if (cell.is_border(border_position::RIGHT)) {
+            _p_table.add(at(i, j), at(i + 1, j), -1.0);
         }
-
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.p(i, j) = -field.p(i, j - 1);
+        if (cell.is_border(border_position::LEFT)) {
+            _p_table.add(at(i, j), at(i - 1, j), -1.0);
+        }
+        if (cell.is_border(border_position::TOP)) {
+            _p_table.add(at(i, j), at(i, j + 1), -1.0);
+        }
+        if (cell.is_border(border_position::BOTTOM)) {
+            _p_table.add(at(i, j), at(i, j - 1), -1.0);
         }
     }
 }
 
-MovingWallBoundary::MovingWallBoundary(std::vector<Cell *> cells, double wall_velocity) : Boundary(cells) {
+MovingWallBoundary::MovingWallBoundary(std::vector<Cell> cells, double wall_velocity) : Boundary(cells) {
     _wall_velocity.insert(std::pair(LidDrivenCavity::moving_wall_id, wall_velocity));
 }
-MovingWallBoundary::MovingWallBoundary(std::vector<Cell *> cells, std::map<int, double> wall_velocity,
+MovingWallBoundary::MovingWallBoundary(std::vector<Cell> cells, std::map<int, double> wall_velocity,
                                        std::map<int, double> wall_temperature)
     : Boundary(cells), _wall_velocity(wall_velocity), _wall_temperature(wall_temperature) {}
-void MovingWallBoundary::applyVelocity(Fields &field) {
 
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
+void MovingWallBoundary::build_tables() {
+    Boundary::build_tables();
+    double wall_velocity = _wall_velocity[GeometryIDs::moving_wall];
+
+    for (const auto &cell : _cells) {
+        int i = cell.i();
+        int j = cell.j();
 
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.u(i, j) = 2 * _wall_velocity[GeometryIDs::moving_wall] - field.u(i, j - 1);
-            field.v(i, j - 1) = 0;
+        if (cell.is_border(border_position::BOTTOM)) {
+            _u_table.add(at(i, j), at(i, j - 1), -1.0, 2 * wall_velocity);
+            _v_table.add(at(i, j - 1), at(i, j - 1), 0.0);
         }
-        if (cell->is_border(border_position::TOP)) {
-            field.u(i, j) = 2 * _wall_velocity[GeometryIDs::moving_wall] - field.u(i, j + 1);
-            field.v(i, j) = 0;
+        if (cell.is_border(border_position::TOP)) {
+            _u_table.add(at(i, j), at(i, j + 1), -1.0, 2 * wall_velocity);
+            _v_table.add(at(i, j), at(i, j), 0.0);
         }
-
-        if (cell->is_border(border_position::RIGHT)) {
-            field.v(i, j) = 2 * _wall_velocity[GeometryIDs::moving_wall] - field.v(i + 1, j);
-            field.u(i, j) = 0;
+        if (cell.is_border(border_position::RIGHT)) {
+            _v_table.add(at(i, j), at(i + 1, j), -1.0, 2 * wall_velocity);
+            _u_table.add(at(i, j), at(i, j), 0.0);
         }
-
-        if (cell->is_border(border_position::LEFT)) {
-            field.v(i, j) = 2 * _wall_velocity[GeometryIDs::moving_wall] - field.v(i - 1, j);
-            field.u(i - 1, j) = 0;
-
+        if (cell.is_border(border_position::LEFT)) {
+            _v_table.add(at(i, j), at(i - 1, j), -1.0, 2 * wall_velocity);
+            _u_table.add(at(i - 1, j), at(i - 1, j), 0.0);
         }
-    }
-}
-void MovingWallBoundary::applyPressure(Fields &field) {
-    for (auto cell : _cells) {
-        int i = cell->i();
-        int j = cell->j();
 
-        if (cell->is_border(border_position::RIGHT)) {
-            field.p(i, j) = field.p(i + 1, j);
+        // Neumann condition for the pressure
+        if (cell.is_border(border_position::RIGHT)) {
+            _p_table.add(at(i, j), at(i + 1, j), 1.0);
         }
-
-        if (cell->is_border(border_position::LEFT)) {
-            field.p(i, j) = field.p(i - 1, j);
+        if (cell.is_border(border_position::LEFT)) {
+            _p_table.add(at(i, j), at(i - 1, j), 1.0);
         }
-
-        if (cell->is_border(border_position::TOP)) {
-            field.p(i, j) = field.p(i, j + 1);
+        if (cell.is_border(border_position::TOP)) {
+            _p_table.add(at(i, j), at(i, j + 1), 1.0);
         }
-
-        if (cell->is_border(border_position::BOTTOM)) {
-            field.p(i, j) = field.p(i, j - 1);
+        if (cell.is_border(border_position::BOTTOM)) {
+            _p_table.add(at(i, j), at(i, j - 1), 1.0);
         }
     }
-}
\ No newline at end of file
+}
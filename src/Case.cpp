@@ -19,6 +19,7 @@ namespace filesystem = std::filesystem;
 
 #include "Case.hpp"
 #include "Enums.hpp"
+#include "Memory.hpp"
 
 Case::Case(std::string file_name, int argn, char **args) {
     // Read input parameters
@@ -48,6 +49,15 @@ Case::Case(std::string file_name, int argn, char **args) {
     double wall_temp_3{};
     double wall_temp_4{};
     double wall_temp_5{};
+    std::string solver{}; /* pressure solver, chosen from the geometry if not given */
+    std::string mg_cycle{"V"}; /* multigrid cycle type */
+    int mg_smoothing{2};       /* multigrid pre- and post-smoothing sweeps */
+    std::string preconditioner{"SGS"}; /* preconditioner of Krylov solvers */
+    int p_extrapolation{-1};           /* order of the initial pressure guess in time */
+    int residual_check{0};             /* iterations between convergence checks of the pressure, 0: default */
+    int adaptive_omg{0};               /* adapt the SOR relaxation factor to the convergence rate */
+    int tile_sweeps{4};                /* sweeps per pass over the memory of the tiled SOR solver */
+    std::string huge_pages{"transparent"}; /* page backing of the fields: none, transparent or explicit */
 
     int num_of_walls{};
 
@@ -97,6 +107,15 @@ Case::Case(std::string file_name, int argn, char **args) {
                 if (var == "wall_temp_3") file >> wall_temp_3;
                 if (var == "wall_temp_4") file >> wall_temp_4;
                 if (var == "wall_temp_5") file >> wall_temp_5;
+                if (var == "solver") file >> solver;
+                if (var == "mg_cycle") file >> mg_cycle;
+                if (var == "mg_smoothing") file >> mg_smoothing;
+                if (var == "preconditioner") file >> preconditioner;
+                if (var == "p_extrapolation") file >> p_extrapolation;
+                if (var == "residual_check") file >> residual_check;
+                if (var == "adaptive_omg") file >> adaptive_omg;
+                if (var == "tile_sweeps") file >> tile_sweeps;
+                if (var == "huge_pages") file >> huge_pages;
             }
         }
     }
@@ -129,13 +148,99 @@ Case::Case(std::string file_name, int argn, char **args) {
 
     MPI_Barrier(MPI_COMM_WORLD);
 
+    Memory::set_huge_pages(Memory::huge_pages_from_string(huge_pages));
     _grid = Grid(_geom_name, domain);
     _field = Fields(nu, dt, tau, _grid.domain().size_x, _grid.domain().size_y, UI, VI, PI, alpha, beta, GX, GY, TI);
 
+    // Placement of the field arrays after their first touch, in rank order
+    int num_ranks = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+    for (int rank = 0; rank < num_ranks; ++rank) {
+        if (rank == my_rank_global) {
+            const Matrix<Real> &U = _field.u_matrix();
+            const Matrix<double> &P = _field.p_matrix();
+            std::cout << "Rank " << rank << " memory, U: " << Memory::placement(U.data(), U.size() * sizeof(Real))
+                      << "; P: " << Memory::placement(P.data(), P.size() * sizeof(double)) << std::endl;
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+
     _discretization = Discretization(domain.dx, domain.dy, gamma);
-    _pressure_solver = std::make_unique<SOR>(omg);
+    bool buoyancy = beta != 0.0 and (GX != 0.0 or GY != 0.0);
+    StencilKernels kernels = StencilKernels::select(domain.dx, domain.dy, gamma, buoyancy);
+    _field.set_kernels(kernels);
+    if (solver.empty()) {
+        solver = FastPoissonSolver::applicable(_grid) ? "FastPoisson" : "SOR";
+    }
+    if (solver == "FastPoisson" and not FastPoissonSolver::applicable(_grid)) {
+        if (my_rank_global == 0) {
+            std::cerr << "FastPoisson solver needs a domain without obstacles, inflow and outflow, using it as "
+                         "preconditioner of PCG"
+                      << std::endl;
+        }
+        solver = "FastPoissonPCG";
+    }
+    if (solver == "TiledSOR" and num_ranks > 1) {
+        if (my_rank_global == 0) {
+            std::cerr << "TiledSOR solver runs on a single process, using RedBlackSOR" << std::endl;
+        }
+        solver = "RedBlackSOR";
+    }
+    if (my_rank_global == 0) {
+        std::cout << "Pressure solver: " << solver << std::endl;
+        std::cout << "Stencil kernels: " << kernels.name << std::endl;
+    }
+
+    if (solver == "FastPoisson") {
+        _pressure_solver = std::make_unique<FastPoissonSolver>(_grid);
+    } else if (solver == "RedBlackSOR") {
+        _pressure_solver = std::make_unique<RedBlackSOR>(omg, _grid, adaptive_omg != 0);
+    } else if (solver == "LineSOR") {
+        _pressure_solver = std::make_unique<LineSOR>(omg, _grid, adaptive_omg != 0);
+    } else if (solver == "TiledSOR") {
+        _pressure_solver = std::make_unique<TiledSOR>(omg, _grid, tile_sweeps);
+    } else if (solver == "MixedPrecisionSOR") {
+        _pressure_solver = std::make_unique<MixedPrecisionSOR>(omg, _grid);
+    } else if (solver == "Multigrid") {
+        _pressure_solver = std::make_unique<Multigrid>(_grid, mg_cycle == "W" ? 2 : 1, mg_smoothing);
+    } else if (solver == "PCG") {
+        _pressure_solver = std::make_unique<PCG>(_grid, preconditioner);
+    } else if (solver == "Schwarz") {
+        _pressure_solver = std::make_unique<PCG>(_grid, "Schwarz");
+    } else if (solver == "AMG") {
+        _pressure_solver = std::make_unique<PCG>(_grid, "AMG");
+    } else if (solver == "FastPoissonPCG") {
+        _pressure_solver = std::make_unique<PCG>(_grid, "FastPoisson");
+    } else if (solver == "Direct") {
+        _pressure_solver = std::make_unique<DirectSolver>(_grid);
+    } else if (solver == "PipelinedCG") {
+        _pressure_solver = std::make_unique<PipelinedCG>(_grid, preconditioner);
+    } else if (solver == "Chebyshev") {
+        _pressure_solver = std::make_unique<Chebyshev>(_grid);
+    } else if (solver == "SOR") {
+        _pressure_solver = std::make_unique<SOR>(omg, _grid, adaptive_omg != 0);
+    } else {
+        if (my_rank_global == 0) {
+            std::cerr << "Unknown pressure solver " << solver << "!" << std::endl;
+        }
+        MPI_Finalize();
+        exit(1);
+    }
+    // Chebyshev iterations have no reductions, the check would be the only one
+    if (residual_check <= 0) {
+        residual_check = solver == "Chebyshev" ? 20 : 1;
+    }
+    _pressure_solver->set_residual_interval(residual_check);
     _max_iter = itermax;
     _tolerance = eps;
+    // SOR converges slower from the extrapolated guess, since it amplifies the
+    // smooth error components SOR leaves in the pressure of the previous steps
+    if (p_extrapolation < 0) {
+        bool exact = solver == "FastPoisson" or solver == "Direct";
+        bool sor = solver == "SOR" or solver == "RedBlackSOR" or solver == "LineSOR" or solver == "TiledSOR";
+        p_extrapolation = (sor or exact) ? 0 : 1;
+    }
+    _p_extrapolation = std::min(p_extrapolation, 2);
 
     MPI_Barrier(MPI_COMM_WORLD);
 
@@ -241,7 +346,7 @@ void Case::set_file_names(std::string file_name) {
  * Apply Flux boundary conditions using applyFlux()
  * Calculate right-hand-side of PPE using calculate_rs() member function of Fields class
  * - Iterate the pressure poisson equation until the residual becomes smaller than the desired tolerance
- *   or the maximum number of the iterations are performed using solve() member function of PressureSolver
+ *   or the maximum number of the iterations are performed using solve_system() member function of PressureSolver
  * - Update pressure boundary conditions after each iteration of the SOR solver
  * - Calculate the velocities u and v using calculate_velocities() member function of Fields class
  * - calculate the maximal timestep size for the next iteration using calculate_dt() member function of Fields class
@@ -297,18 +402,15 @@ void Case::simulate() {
 
         _field.calculate_rs(_grid);
 
-        residual = 1;
-        iter = 0;
-        while (iter < _max_iter and residual > _tolerance) {
-            residual = _pressure_solver->solve(_field, _grid, _boundaries);
-            Communication::communicate(_field.p_matrix());
-
-            for (auto &b : _boundaries) {
-                b->applyPressure(_field);
-            }
-            iter += 1;
-
-            residual = Communication::reduce_sum(residual);
+        if (_p_extrapolation > 0) {
+            _field.extrapolate_pressure(t + dt, _p_extrapolation);
+        }
+        residual = _pressure_solver->solve_system(_field, _grid, _boundaries, _tolerance, _max_iter, iter);
+        // Unconverged pressures would spoil the extrapolation of the next steps
+        if (_p_extrapolation > 0 and iter < _max_iter) {
+            _field.store_pressure(t + dt);
+        } else if (_p_extrapolation > 0) {
+            _field.clear_pressure_history();
         }
 
         iter_vec.push_back(iter);
@@ -337,7 +439,8 @@ void Case::simulate() {
             if (my_rank_global == 0) {
                 std::cout << "\n[" << static_cast<int>((t / _t_end) * 100) << "%"
                           << " completed] " << "Writing Output at t = " << t << "s" << std::endl;
-                std::cout << std::left << "[ " << "Timestep: " << timestep << "\t\tSOR Iterations: " << iter << "\tSOR Residual: " << residual << " ]"<< std::flush;
+                std::cout << std::left << "[ " << "Timestep: " << timestep << "\t\tSOR Iterations: " << iter << "\tSOR Residual: " << residual
+                          << _pressure_solver->statistics() << " ]" << std::flush;
                 if (iter == _max_iter) {
                     std::cout << "\t\t ---> Exceeded max iterations";
                 }
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "Chebyshev.hpp"
+#include "Communication.hpp"
+
+namespace {
+/// Maximum number of Lanczos steps of the first eigenvalue estimate, doubled by every refinement
+constexpr int lanczos_steps = 40;
+/// Limit of the Lanczos steps of the refinements, each step costs two global reductions
+constexpr int max_lanczos_steps = 320;
+/// Relative change of the smallest Ritz value over 10 steps at which the estimate stops
+constexpr double lanczos_tolerance = 0.001;
+/// Safety factors of the largest and the smallest eigenvalue
+constexpr double lambda_max_margin = 1.05;
+constexpr double lambda_min_margin = 0.5;
+
+/**
+ * @brief Number of eigenvalues below x of a symmetric tridiagonal matrix (Sturm sequence)
+ *
+ * @param[in] diagonal
+ * @param[in] off-diagonal, one entry shorter
+ * @param[in] shift x
+ */
+int eigenvalues_below(const std::vector<double> &diag, const std::vector<double> &off, double x) {
+    int count = 0;
+    double q = 1.0;
+    for (std::size_t k = 0; k < diag.size(); ++k) {
+        q = diag[k] - x - (k > 0 ? off[k - 1] * off[k - 1] / q : 0.0);
+        if (q == 0.0) {
+            q = -1e-300;
+        }
+        count += q < 0.0 ? 1 : 0;
+    }
+    return count;
+}
+
+/**
+ * @brief Eigenvalue with the given index of a symmetric tridiagonal matrix by bisection
+ *
+ * @param[in] diagonal
+ * @param[in] off-diagonal, one entry shorter
+ * @param[in] index of the eigenvalue in ascending order
+ */
+double tridiagonal_eigenvalue(const std::vector<double> &diag, const std::vector<double> &off, int index) {
+    // Gershgorin interval
+    double lower = diag[0];
+    double upper = diag[0];
+    for (std::size_t k = 0; k < diag.size(); ++k) {
+        double radius = (k > 0 ? std::abs(off[k - 1]) : 0.0) + (k < off.size() ? std::abs(off[k]) : 0.0);
+        lower = std::min(lower, diag[k] - radius);
+        upper = std::max(upper, diag[k] + radius);
+    }
+    for (int step = 0; step < 100; ++step) {
+        double middle = 0.5 * (lower + upper);
+        if (eigenvalues_below(diag, off, middle) > index) {
+            upper = middle;
+        } else {
+            lower = middle;
+        }
+    }
+    return 0.5 * (lower + upper);
+}
+} // namespace
+
+Chebyshev::Chebyshev(const Grid &grid) : PCG(grid, "SGS") {
+    estimate_bounds(lanczos_steps);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMMUNICATOR, &rank);
+    if (rank == 0) {
+        std::cout << "Chebyshev eigenvalue bounds: [" << _lambda_min << ", " << _lambda_max << "] from "
+                  << _lanczos_steps << " Lanczos steps" << std::endl;
+    }
+}
+
+void Chebyshev::estimate_bounds(int steps) {
+    // The Lanczos matrix cannot have more rows than the operator
+    int limit = static_cast<int>(std::min(static_cast<double>(max_lanczos_steps), _op.global_cells()));
+    steps = std::max(std::min(steps, limit), 1);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMMUNICATOR, &rank);
+    std::minstd_rand generator(rank + 1);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+    int n = _r.size();
+    double *r = _r.data();
+    double *z = _z.data();
+    double *d = _d.data();
+    const double *q = _q.data();
+    const double *m = _op.mask().data();
+
+    // The constant is in the kernel of the singular operator, the start vector has zero mean then
+    double sum = 0.0;
+    for (int c = 0; c < n; ++c) {
+        r[c] = m[c] * uniform(generator);
+        sum += r[c];
+    }
+    double mean = _op.singular() ? Communication::reduce_sum(sum) / std::max(_op.global_cells(), 1.0) : 0.0;
+    for (int c = 0; c < n; ++c) {
+        r[c] = m[c] * (r[c] - mean);
+    }
+    precondition(_r, _z);
+    std::copy(z, z + n, d);
+
+    // CG coefficients give the Lanczos matrix T of M^-1 A
+    std::vector<double> diag;
+    std::vector<double> off;
+    std::vector<double> ritz_min;
+    double rz = Communication::reduce_sum(_op.local_dot(_r, _z));
+    double alpha_old = 1.0;
+    double beta_old = 0.0;
+    for (int k = 0; k < steps and rz > 0.0; ++k) {
+        _op.apply(_d, _q);
+        double dq = Communication::reduce_sum(_op.local_dot(_d, _q));
+        if (dq <= 0.0) {
+            break;
+        }
+        double alpha = rz / dq;
+        for (int c = 0; c < n; ++c) {
+            r[c] -= alpha * q[c];
+        }
+        precondition(_r, _z);
+        double rz_new = Communication::reduce_sum(_op.local_dot(_r, _z));
+        double beta = rz_new / rz;
+        rz = rz_new;
+        for (int c = 0; c < n; ++c) {
+            d[c] = z[c] + beta * d[c];
+        }
+
+        if (k > 0) {
+            off.push_back(std::sqrt(beta_old) / alpha_old);
+        }
+        diag.push_back(1.0 / alpha + beta_old / alpha_old);
+        alpha_old = alpha;
+        beta_old = beta;
+
+        // The smallest Ritz value converges slowest
+        ritz_min.push_back(tridiagonal_eigenvalue(diag, off, 0));
+        if (k >= 10 and ritz_min[k - 10] - ritz_min[k] < lanczos_tolerance * ritz_min[k]) {
+            break;
+        }
+    }
+
+    // More steps do not change an estimate that settled or broke down, and
+    // none are taken beyond the limit. A round-off copy of the kernel of a
+    // singular operator keeps the last bounds.
+    _lanczos_steps = steps;
+    _settled = static_cast<int>(diag.size()) < steps or steps == limit;
+    if (diag.empty() or ritz_min.back() <= 0.0) {
+        return;
+    }
+    _lambda_min = lambda_min_margin * ritz_min.back();
+    _lambda_max = lambda_max_margin * tridiagonal_eigenvalue(diag, off, diag.size() - 1);
+}
+
+double Chebyshev::solve(Fields &field, Grid &, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    restart(field);
+    double rloc = iterate(field, _residual_interval);
+    finish(field, boundaries);
+    return rloc;
+}
+
+double Chebyshev::solve_system(Fields &field, Grid &, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                               double tolerance, int max_iter, int &iter) {
+    // Refinement requested by the last timestep, done between the timesteps
+    if (_refine) {
+        estimate_bounds(2 * _lanczos_steps);
+        _refine = false;
+    }
+
+    double cells = std::max(_op.global_cells(), 1.0);
+    double residual = restart(field);
+    double initial = residual;
+    iter = 0;
+    while (iter < max_iter and residual > tolerance) {
+        int batch = std::min(_residual_interval, max_iter - iter);
+        residual = std::sqrt(Communication::reduce_sum(iterate(field, batch)) / cells);
+        iter += batch;
+
+        // The smallest Ritz value of a few Lanczos steps may still lie well
+        // above the smallest eigenvalue, and the modes below the interval
+        // converge much slower. If the residual falls behind the square root of
+        // the reduction the interval predicts, the bounds are estimated again
+        // with twice the Lanczos steps before the next timestep.
+        double sigma = (_lambda_max + _lambda_min) / (_lambda_max - _lambda_min);
+        double predicted = 2.0 * std::pow(sigma - std::sqrt(sigma * sigma - 1.0), iter);
+        if (not _settled and residual > tolerance and residual > std::sqrt(predicted) * initial) {
+            _refine = true;
+        }
+    }
+    finish(field, boundaries);
+    return residual;
+}
+
+std::string Chebyshev::statistics() const {
+    return "\tLambda min: " + std::to_string(_lambda_min) + " (" + std::to_string(_lanczos_steps) + " Lanczos steps)";
+}
+
+double Chebyshev::restart(Fields &field) {
+    initial_residual(field);
+
+    // First step d = M^-1 r / theta, theta the center of the interval
+    double theta = 0.5 * (_lambda_max + _lambda_min);
+    int n = _r.size();
+    const double *z = _z.data();
+    double *d = _d.data();
+    precondition(_r, _z);
+#pragma omp parallel for simd schedule(static)
+    for (int c = 0; c < n; ++c) {
+        d[c] = z[c] / theta;
+    }
+    _rho = (0.5 * (_lambda_max - _lambda_min)) / theta;
+
+    double cells = std::max(_op.global_cells(), 1.0);
+    return std::sqrt(Communication::reduce_sum(_op.local_dot(_r, _r)) / cells);
+}
+
+double Chebyshev::iterate(Fields &field, int iterations) {
+    double theta = 0.5 * (_lambda_max + _lambda_min);
+    double delta = 0.5 * (_lambda_max - _lambda_min);
+    double sigma = theta / delta;
+
+    int n = _r.size();
+    double *p = field.p_matrix().data();
+    double *r = _r.data();
+    double *d = _d.data();
+    const double *q = _q.data();
+    const double *z = _z.data();
+
+    // Saad, Iterative Methods for Sparse Linear Systems, Algorithm 12.1
+    for (int k = 0; k < iterations; ++k) {
+        _op.apply(_d, _q);
+        double rho = 1.0 / (2.0 * sigma - _rho);
+        double scale_d = rho * _rho;
+        double scale_r = 2.0 * rho / delta;
+        _rho = rho;
+#pragma omp parallel for simd schedule(static)
+        for (int c = 0; c < n; ++c) {
+            p[c] += d[c];
+            r[c] -= q[c];
+        }
+        precondition(_r, _z);
+#pragma omp parallel for simd schedule(static)
+        for (int c = 0; c < n; ++c) {
+            d[c] = scale_d * d[c] + scale_r * z[c];
+        }
+    }
+    return _op.local_dot(_r, _r);
+}
@@ -7,6 +7,13 @@
 
 MPI_Comm MPI_COMMUNICATOR;
 
+namespace {
+// MPI datatype of the matrix elements
+template <typename T> MPI_Datatype mpi_type();
+template <> MPI_Datatype mpi_type<double>() { return MPI_DOUBLE; }
+template <> MPI_Datatype mpi_type<float>() { return MPI_FLOAT; }
+} // namespace
+
 /*
 TODO -->  each process should store here information about its rank and communicator,
 as well as its neighbors. If a process does not have any neighbor in some direction, simply
@@ -92,7 +99,7 @@ std::array<int, 4> Communication::get_neighbours() {
 }
 
 
-void Communication::communicate(Matrix<double> &matrix){
+template <typename T> void Communication::communicate(Matrix<T> &matrix){
     // Get my coordinates in the new communicator
     int my_coords[2];
     MPI_Cart_coords(MPI_COMMUNICATOR, my_rank_global, 2, my_coords);
@@ -103,11 +110,11 @@ void Communication::communicate(Matrix<double> &matrix){
     int inner_index_cols = matrix.num_cols() - 2;
     int inner_index_rows = matrix.num_rows() - 2;
 
-    std::vector<double> send_x(matrix.num_rows(), 0);
-    std::vector<double> rcv_x(matrix.num_rows(), 0);
+    std::vector<T> send_x(matrix.num_rows(), 0);
+    std::vector<T> rcv_x(matrix.num_rows(), 0);
 
-    std::vector<double> send_y(matrix.num_cols(), 0);
-    std::vector<double> rcv_y(matrix.num_cols(), 0);
+    std::vector<T> send_y(matrix.num_cols(), 0);
+    std::vector<T> rcv_y(matrix.num_cols(), 0);
 
     if(neighbours_ranks[RIGHT]!= MPI_PROC_NULL){
 
@@ -115,8 +122,8 @@ void Communication::communicate(Matrix<double> &matrix){
                 send_x[j] = matrix(inner_index_cols,j);
             }
 
-            MPI_Sendrecv(&send_x[0], send_x.size(), MPI_DOUBLE, neighbours_ranks[RIGHT], 0,
-                         &rcv_x[0], rcv_x.size(), MPI_DOUBLE, neighbours_ranks[RIGHT], 0,  MPI_COMMUNICATOR, &status);
+            MPI_Sendrecv(&send_x[0], send_x.size(), mpi_type<T>(), neighbours_ranks[RIGHT], 0,
+                         &rcv_x[0], rcv_x.size(), mpi_type<T>(), neighbours_ranks[RIGHT], 0,  MPI_COMMUNICATOR, &status);
 
             for(int j=0; j< matrix.num_rows(); j++){
                 matrix(inner_index_cols+1,j) = rcv_x[j];
@@ -129,8 +136,8 @@ void Communication::communicate(Matrix<double> &matrix){
                 send_x[j] = matrix(1,j);
             }
 
-            MPI_Sendrecv(&send_x[0], send_x.size(), MPI_DOUBLE, neighbours_ranks[LEFT], 0,
-                         &rcv_x[0], rcv_x.size(), MPI_DOUBLE, neighbours_ranks[LEFT], 0,  MPI_COMMUNICATOR, &status);
+            MPI_Sendrecv(&send_x[0], send_x.size(), mpi_type<T>(), neighbours_ranks[LEFT], 0,
+                         &rcv_x[0], rcv_x.size(), mpi_type<T>(), neighbours_ranks[LEFT], 0,  MPI_COMMUNICATOR, &status);
 
             for(int j=0; j< matrix.num_rows(); j++){
                 matrix(0,j) = rcv_x[j];
@@ -143,8 +150,8 @@ void Communication::communicate(Matrix<double> &matrix){
                 send_y[i] = matrix(i,inner_index_rows);
             }
 
-            MPI_Sendrecv(&send_y[0], send_y.size(), MPI_DOUBLE, neighbours_ranks[UP], 0,
-                         &rcv_y[0], rcv_y.size(), MPI_DOUBLE, neighbours_ranks[UP], 0,  MPI_COMMUNICATOR, &status);
+            MPI_Sendrecv(&send_y[0], send_y.size(), mpi_type<T>(), neighbours_ranks[UP], 0,
+                         &rcv_y[0], rcv_y.size(), mpi_type<T>(), neighbours_ranks[UP], 0,  MPI_COMMUNICATOR, &status);
 
             for(int i=0; i< matrix.num_cols(); i++){
                 matrix(i,inner_index_rows+1) = rcv_y[i];
@@ -157,8 +164,8 @@ void Communication::communicate(Matrix<double> &matrix){
                 send_y[i] = matrix(i,1);
             }
 
-            MPI_Sendrecv(&send_y[0], send_y.size(), MPI_DOUBLE, neighbours_ranks[DOWN], 0,
-                         &rcv_y[0], rcv_y.size(), MPI_DOUBLE, neighbours_ranks[DOWN], 0,  MPI_COMMUNICATOR, &status);
+            MPI_Sendrecv(&send_y[0], send_y.size(), mpi_type<T>(), neighbours_ranks[DOWN], 0,
+                         &rcv_y[0], rcv_y.size(), mpi_type<T>(), neighbours_ranks[DOWN], 0,  MPI_COMMUNICATOR, &status);
 
             for(int i=0; i< matrix.num_cols(); i++){
                 matrix(i,0) = rcv_y[i];
@@ -167,6 +174,134 @@ void Communication::communicate(Matrix<double> &matrix){
     
 }
 
+template <typename T> void Communication::communicate_color(Matrix<T> &matrix, int color, int parity){
+
+    std::array<int,4> neighbours_ranks = get_neighbours();
+
+    MPI_Status status;
+    int inner_index_cols = matrix.num_cols() - 2;
+    int inner_index_rows = matrix.num_rows() - 2;
+
+    std::vector<T> send_buf;
+    std::vector<T> rcv_buf;
+    send_buf.reserve(std::max(matrix.num_cols(), matrix.num_rows()) / 2 + 1);
+    rcv_buf.reserve(std::max(matrix.num_cols(), matrix.num_rows()) / 2 + 1);
+
+    // the cells sent from column/row "send" are received by the neighbour in
+    // its ghost layer, where they have the same color again
+    auto exchange_col = [&](int send, int recv, int neighbour) {
+        send_buf.clear();
+        for (int j = (send + parity + color) % 2; j < matrix.num_rows(); j += 2) {
+            send_buf.push_back(matrix(send, j));
+        }
+        int first = (recv + parity + color) % 2;
+        rcv_buf.resize((matrix.num_rows() - first + 1) / 2);
+
+        MPI_Sendrecv(send_buf.data(), send_buf.size(), mpi_type<T>(), neighbour, 0,
+                     rcv_buf.data(), rcv_buf.size(), mpi_type<T>(), neighbour, 0, MPI_COMMUNICATOR, &status);
+
+        for (int j = first, k = 0; j < matrix.num_rows(); j += 2, ++k) {
+            matrix(recv, j) = rcv_buf[k];
+        }
+    };
+
+    auto exchange_row = [&](int send, int recv, int neighbour) {
+        send_buf.clear();
+        for (int i = (send + parity + color) % 2; i < matrix.num_cols(); i += 2) {
+            send_buf.push_back(matrix(i, send));
+        }
+        int first = (recv + parity + color) % 2;
+        rcv_buf.resize((matrix.num_cols() - first + 1) / 2);
+
+        MPI_Sendrecv(send_buf.data(), send_buf.size(), mpi_type<T>(), neighbour, 0,
+                     rcv_buf.data(), rcv_buf.size(), mpi_type<T>(), neighbour, 0, MPI_COMMUNICATOR, &status);
+
+        for (int i = first, k = 0; i < matrix.num_cols(); i += 2, ++k) {
+            matrix(i, recv) = rcv_buf[k];
+        }
+    };
+
+    if(neighbours_ranks[RIGHT]!= MPI_PROC_NULL){
+        exchange_col(inner_index_cols, inner_index_cols + 1, neighbours_ranks[RIGHT]);
+    }
+
+    if(neighbours_ranks[LEFT]!= MPI_PROC_NULL){
+        exchange_col(1, 0, neighbours_ranks[LEFT]);
+    }
+
+    if(neighbours_ranks[UP]!= MPI_PROC_NULL){
+        exchange_row(inner_index_rows, inner_index_rows + 1, neighbours_ranks[UP]);
+    }
+
+    if(neighbours_ranks[DOWN]!= MPI_PROC_NULL){
+        exchange_row(1, 0, neighbours_ranks[DOWN]);
+    }
+}
+
+void Communication::accumulate(Matrix<double> &matrix){
+
+    std::array<int,4> neighbours_ranks = get_neighbours();
+
+    MPI_Status status;
+    int nx = matrix.num_cols();
+    int ny = matrix.num_rows();
+
+    std::vector<double> send_buf;
+    std::vector<double> rcv_buf;
+
+    // the ghost column/row "send" is added to the inner column/row "add" of the
+    // neighbour, which receives it while sending its own ghost values back
+    auto exchange_col = [&](int send, int add, int neighbour) {
+        send_buf.assign(ny - 2, 0.0);
+        rcv_buf.assign(ny - 2, 0.0);
+        for (int j = 1; j < ny - 1; ++j) {
+            send_buf[j - 1] = matrix(send, j);
+        }
+
+        MPI_Sendrecv(send_buf.data(), send_buf.size(), MPI_DOUBLE, neighbour, 0,
+                     rcv_buf.data(), rcv_buf.size(), MPI_DOUBLE, neighbour, 0, MPI_COMMUNICATOR, &status);
+
+        for (int j = 1; j < ny - 1; ++j) {
+            matrix(add, j) += rcv_buf[j - 1];
+        }
+    };
+
+    auto exchange_row = [&](int send, int add, int neighbour) {
+        send_buf.assign(nx - 2, 0.0);
+        rcv_buf.assign(nx - 2, 0.0);
+        for (int i = 1; i < nx - 1; ++i) {
+            send_buf[i - 1] = matrix(i, send);
+        }
+
+        MPI_Sendrecv(send_buf.data(), send_buf.size(), MPI_DOUBLE, neighbour, 0,
+                     rcv_buf.data(), rcv_buf.size(), MPI_DOUBLE, neighbour, 0, MPI_COMMUNICATOR, &status);
+
+        for (int i = 1; i < nx - 1; ++i) {
+            matrix(i, add) += rcv_buf[i - 1];
+        }
+    };
+
+    if(neighbours_ranks[RIGHT]!= MPI_PROC_NULL){
+        exchange_col(nx - 1, nx - 2, neighbours_ranks[RIGHT]);
+    }
+
+    if(neighbours_ranks[LEFT]!= MPI_PROC_NULL){
+        exchange_col(0, 1, neighbours_ranks[LEFT]);
+    }
+
+    if(neighbours_ranks[UP]!= MPI_PROC_NULL){
+        exchange_row(ny - 1, ny - 2, neighbours_ranks[UP]);
+    }
+
+    if(neighbours_ranks[DOWN]!= MPI_PROC_NULL){
+        exchange_row(0, 1, neighbours_ranks[DOWN]);
+    }
+}
+
+template void Communication::communicate(Matrix<double> &matrix);
+template void Communication::communicate(Matrix<float> &matrix);
+template void Communication::communicate_color(Matrix<double> &matrix, int color, int parity);
+template void Communication::communicate_color(Matrix<float> &matrix, int color, int parity);
 
 double Communication::reduce_min(double value){
     double global_min ;
@@ -175,8 +310,53 @@ double Communication::reduce_min(double value){
 }
 
 
+double Communication::reduce_max(double value){
+    double global_max ;
+    MPI_Allreduce(&value, &global_max, 1, MPI_DOUBLE, MPI_MAX, MPI_COMMUNICATOR);
+    return global_max;
+}
+
+
 double Communication::reduce_sum(double residual){
     double globalsum ;
     MPI_Allreduce(&residual, &globalsum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMMUNICATOR);
     return globalsum;
-}
\ No newline at end of file
+}
+
+
+void Communication::reduce_sum(std::vector<double> &values){
+    MPI_Allreduce(MPI_IN_PLACE, values.data(), values.size(), MPI_DOUBLE, MPI_SUM, MPI_COMMUNICATOR);
+}
+
+
+std::vector<int> Communication::all_gather(int value){
+    int size;
+    MPI_Comm_size(MPI_COMMUNICATOR, &size);
+    std::vector<int> values(size);
+    MPI_Allgather(&value, 1, MPI_INT, values.data(), 1, MPI_INT, MPI_COMMUNICATOR);
+    return values;
+}
+
+
+void Communication::all_gather(const std::vector<double> &values, const std::vector<int> &counts,
+                               std::vector<double> &result){
+    std::vector<int> offsets(counts.size(), 0);
+    for (std::size_t p = 1; p < counts.size(); ++p) {
+        offsets[p] = offsets[p - 1] + counts[p - 1];
+    }
+    result.resize(offsets.back() + counts.back());
+    MPI_Allgatherv(values.data(), values.size(), MPI_DOUBLE, result.data(), counts.data(), offsets.data(),
+                   MPI_DOUBLE, MPI_COMMUNICATOR);
+}
+
+
+MPI_Request Communication::ireduce_sum(std::vector<double> &values){
+    MPI_Request request;
+    MPI_Iallreduce(MPI_IN_PLACE, values.data(), values.size(), MPI_DOUBLE, MPI_SUM, MPI_COMMUNICATOR, &request);
+    return request;
+}
+
+
+void Communication::wait(MPI_Request &request){
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
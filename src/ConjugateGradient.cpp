@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "Communication.hpp"
+#include "ConjugateGradient.hpp"
+
+PCG::PCG(const Grid &grid, const std::string &preconditioner) : _op(grid) {
+    _preconditioner = preconditioner == "Jacobi" ? Preconditioner::Jacobi : Preconditioner::SGS;
+    if (preconditioner == "Schwarz") {
+        _preconditioner = Preconditioner::Schwarz;
+        _schwarz = std::make_unique<AdditiveSchwarz>(_op, grid);
+    } else if (preconditioner == "AMG") {
+        _preconditioner = Preconditioner::AMG;
+        _amg = std::make_unique<AlgebraicMultigrid>(_op, grid);
+    } else if (preconditioner == "FastPoisson") {
+        _preconditioner = Preconditioner::FastPoisson;
+        _fast_poisson = std::make_unique<FastPoissonSolver>(grid);
+    } else if (preconditioner != "Jacobi" and preconditioner != "SGS") {
+        int rank;
+        MPI_Comm_rank(MPI_COMMUNICATOR, &rank);
+        if (rank == 0) {
+            std::cerr << "Unknown preconditioner " << preconditioner << ", using SGS" << std::endl;
+        }
+    }
+
+    int nx = grid.size_x() + 2;
+    int ny = grid.size_y() + 2;
+    _r = Matrix<double>(nx, ny, 0.0);
+    _z = Matrix<double>(nx, ny, 0.0);
+    _d = Matrix<double>(nx, ny, 0.0);
+    _q = Matrix<double>(nx, ny, 0.0);
+}
+
+double PCG::solve(Fields &field, Grid &, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    start(field);
+    double residual;
+    iterate(field, residual);
+    finish(field, boundaries);
+    return _op.local_dot(_r, _r);
+}
+
+double PCG::solve_system(Fields &field, Grid &, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                         double tolerance, int max_iter, int &iter) {
+    double residual = start(field);
+    bool restarted = false;
+    iter = 0;
+    while (iter < max_iter and residual > tolerance) {
+        if (iterate(field, residual)) {
+            restarted = false;
+            iter += 1;
+            continue;
+        }
+        // A breakdown from round-off is cured by restarting from the current
+        // pressure. A second one in a row means that the preconditioned
+        // operator is not positive definite, and the unconverged residual is
+        // returned.
+        if (restarted) {
+            break;
+        }
+        residual = start(field);
+        restarted = true;
+    }
+    finish(field, boundaries);
+    return residual;
+}
+
+void PCG::initial_residual(Fields &field) {
+    Matrix<double> &P = field.p_matrix();
+    const Matrix<double> &RS = field.rs_matrix();
+
+    _op.apply(P, _q);
+
+    int n = P.size();
+    const double *rs = RS.data();
+    const double *m = _op.mask().data();
+    const double *q = _q.data();
+    double *r = _r.data();
+
+    // Without outflow only the part of the right hand side with zero mean can be matched
+    double mean = 0.0;
+    if (_op.singular()) {
+        double sum = 0.0;
+        for (int c = 0; c < n; ++c) {
+            sum += m[c] * rs[c];
+        }
+        mean = Communication::reduce_sum(sum) / std::max(_op.global_cells(), 1.0);
+    }
+
+#pragma omp parallel for simd schedule(static)
+    for (int c = 0; c < n; ++c) {
+        r[c] = m[c] * (mean - rs[c] - q[c]);
+    }
+}
+
+double PCG::start(Fields &field) {
+    initial_residual(field);
+
+    precondition(_r, _z);
+    std::copy(_z.data(), _z.data() + _z.size(), _d.data());
+
+    std::vector<double> sums{_op.local_dot(_r, _z), _op.local_dot(_r, _r)};
+    Communication::reduce_sum(sums);
+    _rz = sums[0];
+    return std::sqrt(sums[1] / std::max(_op.global_cells(), 1.0));
+}
+
+bool PCG::iterate(Fields &field, double &residual) {
+    _op.apply(_d, _q);
+    double dq = Communication::reduce_sum(_op.local_dot(_d, _q));
+    if (not(dq > 0.0)) {
+        // Breakdown, the search direction has no positive curvature
+        residual = std::sqrt(Communication::reduce_sum(_op.local_dot(_r, _r)) / std::max(_op.global_cells(), 1.0));
+        return false;
+    }
+    double alpha = _rz / dq;
+
+    int n = _r.size();
+    double *p = field.p_matrix().data();
+    double *r = _r.data();
+    const double *d = _d.data();
+    const double *q = _q.data();
+#pragma omp parallel for simd schedule(static)
+    for (int c = 0; c < n; ++c) {
+        p[c] += alpha * d[c];
+        r[c] -= alpha * q[c];
+    }
+
+    precondition(_r, _z);
+    std::vector<double> sums{_op.local_dot(_r, _z), _op.local_dot(_r, _r)};
+    Communication::reduce_sum(sums);
+    double beta = sums[0] / _rz;
+    _rz = sums[0];
+
+    double *dd = _d.data();
+    const double *z = _z.data();
+#pragma omp parallel for simd schedule(static)
+    for (int c = 0; c < n; ++c) {
+        dd[c] = z[c] + beta * dd[c];
+    }
+
+    residual = std::sqrt(sums[1] / std::max(_op.global_cells(), 1.0));
+    return true;
+}
+
+void PCG::finish(Fields &field, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+}
+
+void PCG::precondition(const Matrix<double> &R, Matrix<double> &Z) {
+    int nx = R.num_cols();
+    int ny = R.num_rows();
+    int stride = R.stride();
+    int n = R.size();
+    const double *r = R.data();
+    double *z = Z.data();
+    const double *inv_diag = _op.inv_diag().data();
+
+    if (_preconditioner == Preconditioner::Schwarz) {
+        _schwarz->apply(R, Z);
+        return;
+    }
+    if (_preconditioner == Preconditioner::AMG) {
+        _amg->apply(R, Z);
+        return;
+    }
+    if (_preconditioner == Preconditioner::FastPoisson) {
+        // laplacian(z) = -r on the box, the solution is cut back to the coupled cells
+        const double *m = _op.mask().data();
+        _fast_poisson->solve_neumann(R, Z, not _op.singular());
+#pragma omp parallel for simd schedule(static)
+        for (int c = 0; c < n; ++c) {
+            z[c] = -m[c] * z[c];
+        }
+        return;
+    }
+
+    if (_preconditioner == Preconditioner::Jacobi) {
+#pragma omp parallel for simd schedule(static)
+        for (int c = 0; c < n; ++c) {
+            z[c] = inv_diag[c] * r[c];
+        }
+        return;
+    }
+
+    // Forward and backward Gauss-Seidel sweep, M = (D + L) D^-1 (D + U). The
+    // ghost layer stays zero, so the preconditioner is symmetric on every rank.
+    const double *open_x = _op.open_x().data();
+    const double *open_y = _op.open_y().data();
+    double idx2 = _op.idx2();
+    double idy2 = _op.idy2();
+
+    std::fill(z, z + n, 0.0);
+    for (int j = 1; j < ny - 1; ++j) {
+        for (int i = 1; i < nx - 1; ++i) {
+            int c = j * stride + i;
+            z[c] = inv_diag[c] * (r[c] + idx2 * open_x[c - 1] * z[c - 1] + idy2 * open_y[c - stride] * z[c - stride]);
+        }
+    }
+    for (int j = ny - 2; j >= 1; --j) {
+        for (int i = nx - 2; i >= 1; --i) {
+            int c = j * stride + i;
+            z[c] += inv_diag[c] * (idx2 * open_x[c] * z[c + 1] + idy2 * open_y[c] * z[c + stride]);
+        }
+    }
+}
+
+PipelinedCG::PipelinedCG(const Grid &grid, const std::string &preconditioner) : PCG(grid, preconditioner) {
+    int nx = grid.size_x() + 2;
+    int ny = grid.size_y() + 2;
+    _u = Matrix<double>(nx, ny, 0.0);
+    _w = Matrix<double>(nx, ny, 0.0);
+    _m = Matrix<double>(nx, ny, 0.0);
+    _n = Matrix<double>(nx, ny, 0.0);
+    _s = Matrix<double>(nx, ny, 0.0);
+    _mq = Matrix<double>(nx, ny, 0.0);
+    _aq = Matrix<double>(nx, ny, 0.0);
+}
+
+double PipelinedCG::solve_system(Fields &field, Grid &,
+                                 const std::vector<std::unique_ptr<Boundary>> &boundaries, double tolerance,
+                                 int max_iter, int &iter) {
+    initial_residual(field);
+    precondition(_r, _u);
+    _op.apply(_u, _w);
+
+    // The recurrences of the search direction start from zero
+    int size = _r.size();
+    std::fill(_d.data(), _d.data() + size, 0.0);
+    std::fill(_s.data(), _s.data() + size, 0.0);
+    std::fill(_mq.data(), _mq.data() + size, 0.0);
+    std::fill(_aq.data(), _aq.data() + size, 0.0);
+
+    double gamma_old = 1.0;
+    double alpha = 1.0;
+    double residual = 1.0;
+    std::vector<double> sums(3);
+    iter = 0;
+    while (true) {
+        // gamma = (r, u), delta = (w, u) and (r, r) in one reduction, which
+        // overlaps with the preconditioner and operator of the next iteration
+        sums = {_op.local_dot(_r, _u), _op.local_dot(_w, _u), _op.local_dot(_r, _r)};
+        MPI_Request request = Communication::ireduce_sum(sums);
+
+        precondition(_w, _m);
+        _op.apply(_m, _n);
+
+        Communication::wait(request);
+        residual = std::sqrt(sums[2] / std::max(_op.global_cells(), 1.0));
+        if (iter >= max_iter or residual <= tolerance) {
+            break;
+        }
+
+        double gamma = sums[0];
+        double delta = sums[1];
+        double beta = iter > 0 ? gamma / gamma_old : 0.0;
+        double denominator = iter > 0 ? delta - beta * gamma / alpha : delta;
+        if (denominator <= 0.0) {
+            // Converged to round-off, the search direction vanishes
+            break;
+        }
+        alpha = gamma / denominator;
+        gamma_old = gamma;
+
+        double *x = field.p_matrix().data();
+        double *r = _r.data();
+        double *u = _u.data();
+        double *w = _w.data();
+        const double *m = _m.data();
+        const double *n = _n.data();
+        double *d = _d.data();
+        double *s = _s.data();
+        double *mq = _mq.data();
+        double *aq = _aq.data();
+#pragma omp parallel for simd schedule(static)
+        for (int c = 0; c < size; ++c) {
+            aq[c] = n[c] + beta * aq[c];
+            mq[c] = m[c] + beta * mq[c];
+            s[c] = w[c] + beta * s[c];
+            d[c] = u[c] + beta * d[c];
+            x[c] += alpha * d[c];
+            r[c] -= alpha * s[c];
+            u[c] -= alpha * mq[c];
+            w[c] -= alpha * aq[c];
+        }
+        iter += 1;
+    }
+
+    finish(field, boundaries);
+    return residual;
+}
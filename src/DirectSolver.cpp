@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+
+#include "Communication.hpp"
+#include "DirectSolver.hpp"
+
+namespace {
+/**
+ * @brief Reverse Cuthill-McKee ordering of a graph, one connected component after the other
+ *
+ * Each component starts from a pseudo-peripheral node, found by repeated
+ * breadth-first searches from a node of minimum degree in the last level.
+ *
+ * @param[in] neighbours of every node
+ * @param[out] nodes of every connected component
+ * @return nodes in the new order
+ */
+std::vector<int> reverse_cuthill_mckee(const std::vector<std::vector<int>> &adjacency,
+                                       std::vector<std::vector<int>> &components) {
+    int n = adjacency.size();
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> numbered(n, 0);
+    std::vector<int> stamp(n, -1);
+    int search = 0;
+
+    // Breadth-first search over the unnumbered nodes, returns the number of
+    // levels and the position of the first node of the last level
+    auto levels = [&](int root, std::vector<int> &nodes, int &last_level) {
+        nodes.assign(1, root);
+        stamp[root] = ++search;
+        int depth = 1;
+        int level_begin = 0;
+        int level_end = 1;
+        while (true) {
+            for (int k = level_begin; k < level_end; ++k) {
+                for (int nb : adjacency[nodes[k]]) {
+                    if (not numbered[nb] and stamp[nb] != search) {
+                        stamp[nb] = search;
+                        nodes.push_back(nb);
+                    }
+                }
+            }
+            if (static_cast<int>(nodes.size()) == level_end) {
+                last_level = level_begin;
+                return depth;
+            }
+            depth += 1;
+            level_begin = level_end;
+            level_end = nodes.size();
+        }
+    };
+    auto degree = [&](int node) { return adjacency[node].size(); };
+
+    std::vector<int> nodes;
+    for (int start = 0; start < n; ++start) {
+        if (numbered[start]) {
+            continue;
+        }
+
+        int root = start;
+        int last_level = 0;
+        int depth = levels(root, nodes, last_level);
+        while (true) {
+            int next = nodes[last_level];
+            for (std::size_t k = last_level; k < nodes.size(); ++k) {
+                if (degree(nodes[k]) < degree(next)) {
+                    next = nodes[k];
+                }
+            }
+            int next_depth = levels(next, nodes, last_level);
+            if (next_depth <= depth) {
+                break;
+            }
+            root = next;
+            depth = next_depth;
+        }
+
+        // Cuthill-McKee: numbering by levels, neighbours of a node by increasing degree
+        int begin = order.size();
+        order.push_back(root);
+        numbered[root] = 1;
+        for (std::size_t k = begin; k < order.size(); ++k) {
+            int first_new = order.size();
+            for (int nb : adjacency[order[k]]) {
+                if (not numbered[nb]) {
+                    numbered[nb] = 1;
+                    order.push_back(nb);
+                }
+            }
+            std::sort(order.begin() + first_new, order.end(),
+                      [&](int a, int b) { return degree(a) < degree(b); });
+        }
+        components.emplace_back(order.begin() + begin, order.end());
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+} // namespace
+
+DirectSolver::DirectSolver(const Grid &grid) : PressureSolver(grid), _op(grid) {
+    int num_proc;
+    MPI_Comm_size(MPI_COMMUNICATOR, &num_proc);
+    MPI_Comm_rank(MPI_COMMUNICATOR, &_rank);
+
+    // Global cell numbers, the global index of the first inner cell is iminb
+    const Domain &domain = grid.domain();
+    int stride = _op.mask().stride();
+    int global_nx = domain.domain_imax + 2;
+    auto global = [&](int c) { return (domain.jminb + c / stride) * global_nx + domain.iminb + c % stride; };
+
+    // Rows of the coupled cells of this process, off-diagonal entries with global column numbers
+    const double *mask = _op.mask().data();
+    const double *diag = _op.diag().data();
+    const double *open_x = _op.open_x().data();
+    const double *open_y = _op.open_y().data();
+    std::vector<int> keys;
+    std::vector<double> diagonal;
+    std::vector<int> rows;
+    std::vector<int> columns;
+    std::vector<double> values;
+    auto add = [&](int c, int nb, double value) {
+        rows.push_back(global(c));
+        columns.push_back(global(nb));
+        values.push_back(-value);
+    };
+    for (int c = 0; c < _op.mask().size(); ++c) {
+        if (mask[c] == 0.0) {
+            continue;
+        }
+        _cells.push_back(c);
+        keys.push_back(global(c));
+        diagonal.push_back(diag[c]);
+        if (open_x[c - 1] > 0.0) add(c, c - 1, _op.idx2());
+        if (open_x[c] > 0.0) add(c, c + 1, _op.idx2());
+        if (open_y[c - stride] > 0.0) add(c, c - stride, _op.idy2());
+        if (open_y[c] > 0.0) add(c, c + stride, _op.idy2());
+    }
+    for (const auto &link : _op.corner_links()) {
+        add(link.cell, link.neighbour, _op.corner_weight());
+    }
+
+    // Gather the rows on the first process
+    auto gather = [&](auto &local, std::vector<int> &counts, std::vector<int> &offsets, MPI_Datatype type) {
+        int count = local.size();
+        counts.assign(num_proc, 0);
+        MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMMUNICATOR);
+        offsets.assign(num_proc, 0);
+        for (int r = 1; r < num_proc; ++r) {
+            offsets[r] = offsets[r - 1] + counts[r - 1];
+        }
+        std::remove_reference_t<decltype(local)> all(_rank == 0 ? offsets.back() + counts.back() : 0);
+        MPI_Gatherv(local.data(), count, type, all.data(), counts.data(), offsets.data(), type, 0, MPI_COMMUNICATOR);
+        return all;
+    };
+    std::vector<int> entry_counts;
+    std::vector<int> entry_offsets;
+    keys = gather(keys, _counts, _offsets, MPI_INT);
+    diagonal = gather(diagonal, _counts, _offsets, MPI_DOUBLE);
+    rows = gather(rows, entry_counts, entry_offsets, MPI_INT);
+    columns = gather(columns, entry_counts, entry_offsets, MPI_INT);
+    values = gather(values, entry_counts, entry_offsets, MPI_DOUBLE);
+
+    int n = keys.size();
+    _b.resize(_rank == 0 ? n : _cells.size());
+    if (_rank != 0) {
+        return;
+    }
+
+    std::unordered_map<int, int> cell;
+    for (int p = 0; p < n; ++p) {
+        cell[keys[p]] = p;
+    }
+    std::vector<std::vector<int>> adjacency(n);
+    std::vector<double> row_sum(diagonal);
+    for (std::size_t e = 0; e < rows.size(); ++e) {
+        int p = cell.at(rows[e]);
+        adjacency[p].push_back(cell.at(columns[e]));
+        row_sum[p] += values[e];
+    }
+    for (auto &nbs : adjacency) {
+        std::sort(nbs.begin(), nbs.end());
+        nbs.erase(std::unique(nbs.begin(), nbs.end()), nbs.end());
+    }
+
+    std::vector<std::vector<int>> components;
+    std::vector<int> order = reverse_cuthill_mckee(adjacency, components);
+    _position.resize(n);
+    for (int k = 0; k < n; ++k) {
+        _position[order[k]] = k;
+    }
+
+    // A region whose rows all sum to zero has no outflow, its first cell in the ordering is pinned
+    std::vector<char> pinned(n, 0);
+    for (const auto &component : components) {
+        bool neumann = std::all_of(component.begin(), component.end(),
+                                   [&](int p) { return std::abs(row_sum[p]) <= 1e-10 * diagonal[p]; });
+        if (neumann) {
+            int first = *std::min_element(component.begin(), component.end(),
+                                          [&](int a, int b) { return _position[a] < _position[b]; });
+            pinned[first] = 1;
+            _pinned.push_back(_position[first]);
+            _components.emplace_back();
+            for (int p : component) {
+                _components.back().push_back(_position[p]);
+            }
+        }
+    }
+
+    int bandwidth = 0;
+    for (std::size_t e = 0; e < rows.size(); ++e) {
+        bandwidth = std::max(bandwidth, std::abs(_position[cell.at(rows[e])] - _position[cell.at(columns[e])]));
+    }
+    _factor = BandedCholesky(n, bandwidth);
+    for (int p = 0; p < n; ++p) {
+        _factor.add(_position[p], _position[p], pinned[p] ? 1.0 : diagonal[p]);
+    }
+    for (std::size_t e = 0; e < rows.size(); ++e) {
+        int p = cell.at(rows[e]);
+        int q = cell.at(columns[e]);
+        if (_position[p] > _position[q] and not pinned[p] and not pinned[q]) {
+            _factor.add(_position[p], _position[q], values[e]);
+        }
+    }
+    int singular = _factor.factorize();
+    _x.resize(n);
+
+    std::cout << "Direct solver: " << n << " unknowns, bandwidth " << bandwidth << ", factor memory "
+              << _factor.memory() / (1024.0 * 1024.0) << " MB, " << _pinned.size() + singular
+              << " pinned pressure value(s)" << std::endl;
+}
+
+double DirectSolver::solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    // A p = -RS on the coupled cells, see PoissonOperator
+    const double *rs = field.rs_matrix().data();
+    std::vector<double> local(_cells.size());
+    for (std::size_t k = 0; k < _cells.size(); ++k) {
+        local[k] = -rs[_cells[k]];
+    }
+    MPI_Gatherv(local.data(), local.size(), MPI_DOUBLE, _b.data(), _counts.data(), _offsets.data(), MPI_DOUBLE, 0,
+                MPI_COMMUNICATOR);
+
+    if (_rank == 0) {
+        int n = _b.size();
+        for (int p = 0; p < n; ++p) {
+            _x[_position[p]] = _b[p];
+        }
+        // Only the part of the right hand side with zero mean can be matched in a Neumann region
+        for (const auto &component : _components) {
+            double mean = 0.0;
+            for (int k : component) {
+                mean += _x[k];
+            }
+            mean /= component.size();
+            for (int k : component) {
+                _x[k] -= mean;
+            }
+        }
+        for (int k : _pinned) {
+            _x[k] = 0.0;
+        }
+        _factor.solve(_x);
+        for (int p = 0; p < n; ++p) {
+            _b[p] = _x[_position[p]];
+        }
+    }
+
+    MPI_Scatterv(_b.data(), _counts.data(), _offsets.data(), MPI_DOUBLE, local.data(), local.size(), MPI_DOUBLE, 0,
+                 MPI_COMMUNICATOR);
+    double *p = field.p_matrix().data();
+    for (std::size_t k = 0; k < _cells.size(); ++k) {
+        p[_cells[k]] = local[k];
+    }
+
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    return residual(field, grid);
+}
+
+double DirectSolver::solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                  double /*tolerance*/, int /*max_iter*/, int &iter) {
+    double rloc = solve(field, grid, boundaries);
+    iter = 1;
+
+    return std::sqrt(Communication::reduce_sum(rloc) / _global_cells);
+}
+
+double DirectSolver::residual(Fields &field, const Grid &grid) const {
+    double rloc = 0.0;
+    for (const auto &currentCell : grid.fluid_cells()) {
+        int i = currentCell.i();
+        int j = currentCell.j();
+
+        double val = Discretization::laplacian(field.p_matrix(), i, j) - field.rs(i, j);
+        rloc += (val * val);
+    }
+    return rloc;
+}
@@ -47,7 +47,7 @@ double Discretization::convection_t(const Matrix<double> &T, const Matrix<double
 }
 
 double Discretization::laplacian(const Matrix<double> &A, int i, int j) {
-    return (A(i+1,j) - 2*A(i,j) + A(i-1,j))/std::pow(_dx,2) + (A(i,j+1) - 2*A(i,j) + A(i,j-1))/std::pow(_dy,2);
+    return (A(i+1,j) - 2*A(i,j) + A(i-1,j))/(_dx * _dx) + (A(i,j+1) - 2*A(i,j) + A(i,j-1))/(_dy * _dy);
 }
 
 double Discretization::sor_helper(const Matrix<double> &P, int i, int j) {
@@ -57,4 +57,180 @@ double Discretization::sor_helper(const Matrix<double> &P, int i, int j) {
 
 double Discretization::interpolate(const Matrix<double> &A, int i, int j, int i_offset, int j_offset) {
     return (A(i, j) + A(i+i_offset, j+j_offset))/2;
-}
\ No newline at end of file
+}
+
+// Runtime selection of the vector instruction set for the row kernels, where
+// the toolchain supports function multiversioning
+#if defined(__x86_64__) && defined(__ELF__) && defined(__GNUC__)
+#define FLUIDCHEN_ROW_KERNEL __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define FLUIDCHEN_ROW_KERNEL
+#endif
+
+namespace {
+/// Constants in the precision of the fields, so float kernels stay in float
+constexpr Real half = 0.5;
+constexpr Real two = 2.0;
+constexpr Real four = 4.0;
+
+/// Factors of the stencils, derived once per row from the coefficients
+struct Factors {
+    Real idx;
+    Real idy;
+    Real idx2;
+    Real idy2;
+    /// weights of the donor-cell parts, gamma / (2 dx) and gamma / (2 dy)
+    Real upwind_x;
+    Real upwind_y;
+};
+
+template <Upwinding upwinding> Factors factors(const StencilCoefficients &k) {
+    double gamma = upwinding == Upwinding::Full ? 1.0 : k.gamma;
+    Factors factors;
+    factors.idx = k.idx;
+    factors.idy = k.idy;
+    factors.idx2 = k.idx * k.idx;
+    factors.idy2 = k.idy * k.idy;
+    factors.upwind_x = 0.5 * gamma * k.idx;
+    factors.upwind_y = 0.5 * gamma * k.idy;
+    return factors;
+}
+
+/// Central part of a convective difference, with the face values a and b east and west
+inline Real central(Real a_e, Real b_e, Real a_w, Real b_w) { return a_e * b_e - a_w * b_w; }
+
+/// Donor-cell part of a convective difference of the transported values c
+inline Real donor(Real a_e, Real a_w, Real c_w, Real c, Real c_e) {
+    return std::abs(a_e) * (c - c_e) - std::abs(a_w) * (c_w - c);
+}
+
+/// Convective term from the central and donor-cell parts in x and y direction, the
+/// donor-cell parts are dead code for central differences and removed by the compiler
+template <Upwinding upwinding, bool square>
+inline Real convection(const Factors &k, Real central_x, Real central_y, Real donor_x, Real donor_y) {
+    Real result = square ? k.idx * (central_x + central_y) : k.idx * central_x + k.idy * central_y;
+    if constexpr (upwinding != Upwinding::Central) {
+        result += square ? k.upwind_x * (donor_x + donor_y) : k.upwind_x * donor_x + k.upwind_y * donor_y;
+    }
+    return result;
+}
+
+/// Five point laplacian with the values at the cell and west, east, south and north of it
+template <bool square> inline Real laplacian(const Factors &k, Real c, Real w, Real e, Real s, Real n) {
+    if constexpr (square) {
+        return (w + e + s + n - four * c) * k.idx2;
+    } else {
+        return (e - two * c + w) * k.idx2 + (n - two * c + s) * k.idy2;
+    }
+}
+
+template <Upwinding upwinding, bool square, bool buoyancy>
+FLUIDCHEN_ROW_KERNEL void flux_f_row(const Real *U, const Real *V, const Real *T, int stride, int first,
+                                     int last, const StencilCoefficients &coefficients, Real *F) {
+    const int s = stride;
+    const Factors k = factors<upwinding>(coefficients);
+    const Real nu = coefficients.nu;
+    const Real dt = coefficients.dt;
+    const Real buoyancy_x = coefficients.buoyancy_x;
+#pragma omp simd
+    for (int i = first; i <= last; ++i) {
+        Real u_e = half * (U[i] + U[i + 1]);
+        Real u_w = half * (U[i - 1] + U[i]);
+        Real u_n = half * (U[i] + U[i + s]);
+        Real u_s = half * (U[i - s] + U[i]);
+        Real v_n = half * (V[i] + V[i + 1]);
+        Real v_s = half * (V[i - s] + V[i - s + 1]);
+        Real conv = convection<upwinding, square>(k, central(u_e, u_e, u_w, u_w), central(v_n, u_n, v_s, u_s),
+                                                    donor(u_e, u_w, U[i - 1], U[i], U[i + 1]),
+                                                    donor(v_n, v_s, U[i - s], U[i], U[i + s]));
+        Real f = U[i] + dt * (nu * laplacian<square>(k, U[i], U[i - 1], U[i + 1], U[i - s], U[i + s]) - conv);
+        if constexpr (buoyancy) {
+            f -= buoyancy_x * (T[i] + T[i + 1]);
+        }
+        F[i] = f;
+    }
+}
+
+template <Upwinding upwinding, bool square, bool buoyancy>
+FLUIDCHEN_ROW_KERNEL void flux_g_row(const Real *U, const Real *V, const Real *T, int stride, int first,
+                                     int last, const StencilCoefficients &coefficients, Real *G) {
+    const int s = stride;
+    const Factors k = factors<upwinding>(coefficients);
+    const Real nu = coefficients.nu;
+    const Real dt = coefficients.dt;
+    const Real buoyancy_y = coefficients.buoyancy_y;
+#pragma omp simd
+    for (int i = first; i <= last; ++i) {
+        Real v_n = half * (V[i] + V[i + s]);
+        Real v_s = half * (V[i - s] + V[i]);
+        Real v_e = half * (V[i] + V[i + 1]);
+        Real v_w = half * (V[i - 1] + V[i]);
+        Real u_e = half * (U[i] + U[i + s]);
+        Real u_w = half * (U[i - 1] + U[i - 1 + s]);
+        Real conv = convection<upwinding, square>(k, central(u_e, v_e, u_w, v_w), central(v_n, v_n, v_s, v_s),
+                                                    donor(u_e, u_w, V[i - 1], V[i], V[i + 1]),
+                                                    donor(v_n, v_s, V[i - s], V[i], V[i + s]));
+        Real g = V[i] + dt * (nu * laplacian<square>(k, V[i], V[i - 1], V[i + 1], V[i - s], V[i + s]) - conv);
+        if constexpr (buoyancy) {
+            g -= buoyancy_y * (T[i] + T[i + s]);
+        }
+        G[i] = g;
+    }
+}
+
+template <Upwinding upwinding, bool square>
+FLUIDCHEN_ROW_KERNEL void temperature_row(const Real *T, const Real *U, const Real *V, int stride, int first,
+                                          int last, const StencilCoefficients &coefficients, Real *T_next) {
+    const int s = stride;
+    const Factors k = factors<upwinding>(coefficients);
+    const Real alpha = coefficients.alpha;
+    const Real dt = coefficients.dt;
+#pragma omp simd
+    for (int i = first; i <= last; ++i) {
+        Real t_e = half * (T[i] + T[i + 1]);
+        Real t_w = half * (T[i - 1] + T[i]);
+        Real t_n = half * (T[i] + T[i + s]);
+        Real t_s = half * (T[i - s] + T[i]);
+        Real conv = convection<upwinding, square>(k, central(U[i], t_e, U[i - 1], t_w),
+                                                    central(V[i], t_n, V[i - s], t_s),
+                                                    donor(U[i], U[i - 1], T[i - 1], T[i], T[i + 1]),
+                                                    donor(V[i], V[i - s], T[i - s], T[i], T[i + s]));
+        Real rate = alpha * laplacian<square>(k, T[i], T[i - 1], T[i + 1], T[i - s], T[i + s]) - conv;
+        T_next[i] = T[i] + dt * rate;
+    }
+}
+
+template <Upwinding upwinding, bool square, bool buoyancy> StencilKernels instantiate() {
+    StencilKernels kernels;
+    kernels.flux_f = flux_f_row<upwinding, square, buoyancy>;
+    kernels.flux_g = flux_g_row<upwinding, square, buoyancy>;
+    kernels.temperature = temperature_row<upwinding, square>;
+    return kernels;
+}
+
+template <Upwinding upwinding> StencilKernels instantiate(bool square, bool buoyancy) {
+    if (square) {
+        return buoyancy ? instantiate<upwinding, true, true>() : instantiate<upwinding, true, false>();
+    }
+    return buoyancy ? instantiate<upwinding, false, true>() : instantiate<upwinding, false, false>();
+}
+} // namespace
+
+StencilKernels StencilKernels::select(double dx, double dy, double gamma, bool buoyancy) {
+    bool square = dx == dy;
+    StencilKernels kernels;
+    std::string scheme;
+    if (gamma == 0.0) {
+        kernels = instantiate<Upwinding::Central>(square, buoyancy);
+        scheme = "central differences";
+    } else if (gamma == 1.0) {
+        kernels = instantiate<Upwinding::Full>(square, buoyancy);
+        scheme = "donor-cell";
+    } else {
+        kernels = instantiate<Upwinding::Blended>(square, buoyancy);
+        scheme = "blended donor-cell";
+    }
+    kernels.gamma = gamma;
+    kernels.name = std::string(square ? "square cells, " : "") + scheme + (buoyancy ? ", buoyancy" : "");
+    return kernels;
+}
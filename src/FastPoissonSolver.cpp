@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Communication.hpp"
+#include "FastPoissonSolver.hpp"
+
+namespace {
+/// Complex product without the inf/nan recovery of operator*, which is a library call unless -ffast-math is set
+inline std::complex<double> multiply(std::complex<double> a, std::complex<double> b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+} // namespace
+
+CosineTransform::CosineTransform(int length, Ends ends)
+    : _ends(ends), _length(length), _n(ends == Ends::Neumann ? length : 2 * length) {
+    _shift.resize(_n);
+    for (int k = 0; k < _n; ++k) {
+        _shift[k] = std::polar(1.0, -M_PI * k / (2.0 * _n));
+    }
+
+    // Bluestein: the DFT is a convolution with the chirp, computed with power of two FFTs
+    if ((_n & (_n - 1)) != 0) {
+        _m = 1;
+        while (_m < 2 * _n - 1) {
+            _m *= 2;
+        }
+    }
+    int radix2_length = _m == 0 ? _n : _m;
+    _roots.resize(radix2_length / 2);
+    for (int k = 0; k < radix2_length / 2; ++k) {
+        _roots[k] = std::polar(1.0, -2.0 * M_PI * k / radix2_length);
+    }
+    if (_m == 0) {
+        return;
+    }
+
+    _chirp.resize(_n);
+    for (long long k = 0; k < _n; ++k) {
+        // k^2 mod 2N keeps the argument small
+        _chirp[k] = std::polar(1.0, -M_PI * static_cast<double>((k * k) % (2 * _n)) / _n);
+    }
+    _chirp_hat.assign(_m, 0.0);
+    _chirp_hat[0] = std::conj(_chirp[0]);
+    for (int k = 1; k < _n; ++k) {
+        _chirp_hat[k] = std::conj(_chirp[k]);
+        _chirp_hat[_m - k] = std::conj(_chirp[k]);
+    }
+    fft_radix2(_chirp_hat.data(), _m, false);
+}
+
+int CosineTransform::scratch_size() const { return _n + _m; }
+
+double CosineTransform::eigenvalue(int k, double h) const {
+    // Wave number k of a line with a Dirichlet end is 2k + 1 of the extended line
+    int wave = _ends == Ends::Neumann ? k : 2 * k + 1;
+    double s = std::sin(M_PI * wave / (2.0 * _n));
+    return -4.0 * s * s / (h * h);
+}
+
+double CosineTransform::extended(const double *line, int stride, int n) const {
+    if (_ends == Ends::DirichletLast) {
+        return n < _length ? line[n * stride] : -line[(_n - 1 - n) * stride];
+    }
+    return n < _length ? -line[(_length - 1 - n) * stride] : line[(n - _length) * stride];
+}
+
+void CosineTransform::forward(double *line, int stride, std::vector<std::complex<double>> &scratch) const {
+    std::complex<double> *v = scratch.data();
+
+    // Even values in ascending, odd values in descending order
+    if (_ends == Ends::Neumann) {
+        for (int n = 0; 2 * n < _n; ++n) {
+            v[n] = line[2 * n * stride];
+        }
+        for (int n = 0; 2 * n + 1 < _n; ++n) {
+            v[_n - 1 - n] = line[(2 * n + 1) * stride];
+        }
+    } else {
+        for (int n = 0; 2 * n < _n; ++n) {
+            v[n] = extended(line, stride, 2 * n);
+        }
+        for (int n = 0; 2 * n + 1 < _n; ++n) {
+            v[_n - 1 - n] = extended(line, stride, 2 * n + 1);
+        }
+    }
+
+    fft(v, v + _n, false);
+
+    // The even wave numbers of an antisymmetric extension vanish
+    if (_ends == Ends::Neumann) {
+        for (int k = 0; k < _n; ++k) {
+            line[k * stride] = std::real(multiply(_shift[k], v[k]));
+        }
+    } else {
+        for (int k = 0; k < _length; ++k) {
+            line[k * stride] = std::real(multiply(_shift[2 * k + 1], v[2 * k + 1]));
+        }
+    }
+}
+
+void CosineTransform::inverse(double *line, int stride, std::vector<std::complex<double>> &scratch) const {
+    std::complex<double> *v = scratch.data();
+
+    if (_ends == Ends::Neumann) {
+        v[0] = line[0];
+        for (int k = 1; k < _n; ++k) {
+            v[k] = multiply(std::conj(_shift[k]), {line[k * stride], -line[(_n - k) * stride]});
+        }
+    } else {
+        // Wave numbers k and _n - k are both odd, since _n is even
+        v[0] = 0.0;
+        for (int k = 1; k < _n; ++k) {
+            double real = k % 2 == 1 ? line[(k / 2) * stride] : 0.0;
+            double imag = k % 2 == 1 ? -line[((_n - k) / 2) * stride] : 0.0;
+            v[k] = multiply(std::conj(_shift[k]), {real, imag});
+        }
+    }
+
+    fft(v, v + _n, true);
+
+    if (_ends == Ends::Neumann) {
+        for (int n = 0; 2 * n < _n; ++n) {
+            line[2 * n * stride] = std::real(v[n]) / _n;
+        }
+        for (int n = 0; 2 * n + 1 < _n; ++n) {
+            line[(2 * n + 1) * stride] = std::real(v[_n - 1 - n]) / _n;
+        }
+        return;
+    }
+
+    // Keep the half of the extended line that holds the original one
+    int offset = _ends == Ends::DirichletFirst ? _length : 0;
+    for (int n = offset; n < offset + _length; ++n) {
+        double value = n % 2 == 0 ? std::real(v[n / 2]) : std::real(v[_n - 1 - n / 2]);
+        line[(n - offset) * stride] = value / _n;
+    }
+}
+
+void CosineTransform::fft(std::complex<double> *data, std::complex<double> *work, bool inverse) const {
+    if (_m == 0) {
+        fft_radix2(data, _n, inverse);
+        return;
+    }
+
+    // The inverse transform is the conjugate of the forward transform of the conjugate
+    if (inverse) {
+        for (int k = 0; k < _n; ++k) {
+            data[k] = std::conj(data[k]);
+        }
+    }
+
+    for (int k = 0; k < _n; ++k) {
+        work[k] = multiply(data[k], _chirp[k]);
+    }
+    std::fill(work + _n, work + _m, 0.0);
+    fft_radix2(work, _m, false);
+    for (int k = 0; k < _m; ++k) {
+        work[k] = multiply(work[k], _chirp_hat[k]);
+    }
+    fft_radix2(work, _m, true);
+    for (int k = 0; k < _n; ++k) {
+        data[k] = multiply(_chirp[k], work[k]) / static_cast<double>(_m);
+    }
+
+    if (inverse) {
+        for (int k = 0; k < _n; ++k) {
+            data[k] = std::conj(data[k]);
+        }
+    }
+}
+
+void CosineTransform::fft_radix2(std::complex<double> *data, int length, bool inverse) const {
+    for (int i = 1, j = 0; i < length; ++i) {
+        int bit = length >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    // _roots holds exp(-2 pi i k / size) for the largest radix-2 length
+    int size = 2 * _roots.size();
+    for (int len = 2; len <= length; len <<= 1) {
+        for (int k = 0; k < len / 2; ++k) {
+            std::complex<double> w = _roots[k * (size / len)];
+            if (inverse) {
+                w = std::conj(w);
+            }
+            for (int i = k; i < length; i += len) {
+                std::complex<double> a = data[i];
+                std::complex<double> b = multiply(data[i + len / 2], w);
+                data[i] = a + b;
+                data[i + len / 2] = a - b;
+            }
+        }
+    }
+}
+
+FastPoissonSolver::FastPoissonSolver(const Grid &grid) : PressureSolver(grid), _dx(grid.dx()), _dy(grid.dy()) {
+    int num_proc;
+    MPI_Comm_size(MPI_COMMUNICATOR, &num_proc);
+    MPI_Comm_rank(MPI_COMMUNICATOR, &_rank);
+
+    // Global index of the first inner cell is iminb, since iminb belongs to the ghost cell
+    const Domain &domain = grid.domain();
+    Box block{domain.iminb, domain.iminb + grid.size_x(), domain.jminb, domain.jminb + grid.size_y()};
+    _blocks.resize(num_proc);
+    MPI_Allgather(&block, 4, MPI_INT, _blocks.data(), 4, MPI_INT, MPI_COMMUNICATOR);
+
+    // The extent covered by the blocks, equal to imax x jmax if the decomposition is even
+    for (const auto &b : _blocks) {
+        _imax = std::max(_imax, b.i_end);
+        _jmax = std::max(_jmax, b.j_end);
+    }
+    // Sides of the domain that are outflow along their whole length carry the
+    // Dirichlet condition of the outflow, all others are walls or inflows
+    auto outflow_side = [&](bool touches, int i_begin, int i_end, int j_begin, int j_end) {
+        bool outflow = true;
+        for (int j = j_begin; touches and j <= j_end; ++j) {
+            for (int i = i_begin; i <= i_end; ++i) {
+                outflow = outflow and grid.cell(i, j).type() == cell_type::ZERO_GRADIENT;
+            }
+        }
+        return Communication::reduce_min(outflow ? 1.0 : 0.0) == 1.0;
+    };
+    int nx = grid.size_x();
+    int ny = grid.size_y();
+    bool left = outflow_side(block.i_begin == 0, 0, 0, 1, ny);
+    bool right = outflow_side(block.i_end == _imax, nx + 1, nx + 1, 1, ny);
+    bool bottom = outflow_side(block.j_begin == 0, 1, nx, 0, 0);
+    bool top = outflow_side(block.j_end == _jmax, 1, nx, ny + 1, ny + 1);
+    // A line with two Dirichlet ends is not covered by the transform, the last one is kept
+    auto ends = [](bool first, bool last) {
+        using Ends = CosineTransform::Ends;
+        return last ? Ends::DirichletLast : (first ? Ends::DirichletFirst : Ends::Neumann);
+    };
+    _dct_x = CosineTransform(_imax, ends(left, right));
+    _dct_y = CosineTransform(_jmax, ends(bottom, top));
+    for (int k = 0; k < _imax; ++k) {
+        _eigenvalues_x.push_back(_dct_x.eigenvalue(k, _dx));
+    }
+    for (int k = 0; k < _jmax; ++k) {
+        _eigenvalues_y.push_back(_dct_y.eigenvalue(k, _dy));
+    }
+
+    for (int r = 0; r < num_proc; ++r) {
+        _rows.push_back({0, _imax, r * _jmax / num_proc, (r + 1) * _jmax / num_proc});
+        _columns.push_back({r * _imax / num_proc, (r + 1) * _imax / num_proc, 0, _jmax});
+    }
+    _row_data.resize((_rows[_rank].j_end - _rows[_rank].j_begin) * _imax);
+    _column_data.resize((_columns[_rank].i_end - _columns[_rank].i_begin) * _jmax);
+}
+
+bool FastPoissonSolver::applicable(const Grid &grid) {
+    // Inner obstacle cells also include the corners of the surrounding walls,
+    // obstacles inside the domain show up as missing fluid cells instead
+    bool local = static_cast<int>(grid.fluid_cells().size()) == grid.size_x() * grid.size_y() and
+                 grid.fixed_velocity_cells().empty() and grid.zero_gradient_cells().empty();
+    return Communication::reduce_min(local ? 1.0 : 0.0) == 1.0;
+}
+
+double FastPoissonSolver::solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    solve_neumann(field.rs_matrix(), field.p_matrix());
+
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    return residual(field, grid);
+}
+
+double FastPoissonSolver::solve_system(Fields &field, Grid &grid,
+                                       const std::vector<std::unique_ptr<Boundary>> &boundaries, double /*tolerance*/,
+                                       int /*max_iter*/, int &iter) {
+    double rloc = solve(field, grid, boundaries);
+    iter = 1;
+
+    return std::sqrt(Communication::reduce_sum(rloc) / _global_cells);
+}
+
+void FastPoissonSolver::solve_neumann(const Matrix<double> &b, Matrix<double> &x, bool keep_constant) {
+    const Box &block = _blocks[_rank];
+    const Box &rows = _rows[_rank];
+    const Box &columns = _columns[_rank];
+    int stride = b.stride();
+
+    auto block_index = [&](int i, int j) { return (j - block.j_begin + 1) * stride + (i - block.i_begin + 1); };
+    auto row_index = [&](int i, int j) { return (j - rows.j_begin) * _imax + i; };
+    auto column_index = [&](int i, int j) { return (i - columns.i_begin) * _jmax + j; };
+
+    redistribute(_blocks, _rows, b.data(), block_index, _row_data.data(), row_index);
+    transform_rows(false);
+    redistribute(_rows, _columns, _row_data.data(), row_index, _column_data.data(), column_index);
+    transform_columns(false);
+
+    // The eigenvalues are negative, the smoothest nonconstant mode has the one closest to zero. With an
+    // outflow side there is no constant mode.
+    double constant_eigenvalue = 0.0;
+    if (keep_constant) {
+        constant_eigenvalue = std::max(_imax > 1 ? _eigenvalues_x[1] : -1.0 / (_dx * _dx),
+                                       _jmax > 1 ? _eigenvalues_y[1] : -1.0 / (_dy * _dy));
+    }
+
+    // Both transforms are unnormalized, the inverse transforms take care of the scaling
+#pragma omp parallel for schedule(static)
+    for (int i = columns.i_begin; i < columns.i_end; ++i) {
+        double *column = _column_data.data() + (i - columns.i_begin) * _jmax;
+        for (int j = 0; j < _jmax; ++j) {
+            double eigenvalue = _eigenvalues_x[i] + _eigenvalues_y[j];
+            if (eigenvalue == 0.0) {
+                column[j] = keep_constant ? column[j] / constant_eigenvalue : 0.0;
+            } else {
+                column[j] /= eigenvalue;
+            }
+        }
+    }
+
+    transform_columns(true);
+    redistribute(_columns, _rows, _column_data.data(), column_index, _row_data.data(), row_index);
+    transform_rows(true);
+    redistribute(_rows, _blocks, _row_data.data(), row_index, x.data(), block_index);
+}
+
+template <typename FromIndex, typename ToIndex>
+void FastPoissonSolver::redistribute(const std::vector<Box> &from, const std::vector<Box> &to, const double *source,
+                                     FromIndex from_index, double *target, ToIndex to_index) const {
+    auto overlap = [](const Box &a, const Box &b) {
+        return Box{std::max(a.i_begin, b.i_begin), std::min(a.i_end, b.i_end), std::max(a.j_begin, b.j_begin),
+                   std::min(a.j_end, b.j_end)};
+    };
+    auto count = [](const Box &box) {
+        return std::max(box.i_end - box.i_begin, 0) * std::max(box.j_end - box.j_begin, 0);
+    };
+
+    int num_proc = from.size();
+    std::vector<int> send_counts(num_proc), send_displs(num_proc), recv_counts(num_proc), recv_displs(num_proc);
+    int send_total = 0;
+    int recv_total = 0;
+    for (int r = 0; r < num_proc; ++r) {
+        send_counts[r] = count(overlap(from[_rank], to[r]));
+        recv_counts[r] = count(overlap(from[r], to[_rank]));
+        send_displs[r] = send_total;
+        recv_displs[r] = recv_total;
+        send_total += send_counts[r];
+        recv_total += recv_counts[r];
+    }
+
+    std::vector<double> send(send_total);
+    std::vector<double> recv(recv_total);
+    int pos = 0;
+    for (int r = 0; r < num_proc; ++r) {
+        Box box = overlap(from[_rank], to[r]);
+        for (int j = box.j_begin; j < box.j_end; ++j) {
+            for (int i = box.i_begin; i < box.i_end; ++i) {
+                send[pos++] = source[from_index(i, j)];
+            }
+        }
+    }
+
+    MPI_Alltoallv(send.data(), send_counts.data(), send_displs.data(), MPI_DOUBLE, recv.data(), recv_counts.data(),
+                  recv_displs.data(), MPI_DOUBLE, MPI_COMMUNICATOR);
+
+    pos = 0;
+    for (int r = 0; r < num_proc; ++r) {
+        Box box = overlap(from[r], to[_rank]);
+        for (int j = box.j_begin; j < box.j_end; ++j) {
+            for (int i = box.i_begin; i < box.i_end; ++i) {
+                target[to_index(i, j)] = recv[pos++];
+            }
+        }
+    }
+}
+
+void FastPoissonSolver::transform_rows(bool inverse) {
+    int num_rows = _rows[_rank].j_end - _rows[_rank].j_begin;
+#pragma omp parallel
+    {
+        std::vector<std::complex<double>> scratch(_dct_x.scratch_size());
+#pragma omp for schedule(static)
+        for (int r = 0; r < num_rows; ++r) {
+            double *line = _row_data.data() + r * _imax;
+            if (inverse) {
+                _dct_x.inverse(line, 1, scratch);
+            } else {
+                _dct_x.forward(line, 1, scratch);
+            }
+        }
+    }
+}
+
+void FastPoissonSolver::transform_columns(bool inverse) {
+    int num_columns = _columns[_rank].i_end - _columns[_rank].i_begin;
+#pragma omp parallel
+    {
+        std::vector<std::complex<double>> scratch(_dct_y.scratch_size());
+#pragma omp for schedule(static)
+        for (int c = 0; c < num_columns; ++c) {
+            double *line = _column_data.data() + c * _jmax;
+            if (inverse) {
+                _dct_y.inverse(line, 1, scratch);
+            } else {
+                _dct_y.forward(line, 1, scratch);
+            }
+        }
+    }
+}
+
+double FastPoissonSolver::residual(Fields &field, const Grid &grid) const {
+    double rloc = 0.0;
+    for (const auto &currentCell : grid.fluid_cells()) {
+        int i = currentCell.i();
+        int j = currentCell.j();
+
+        double val = Discretization::laplacian(field.p_matrix(), i, j) - field.rs(i, j);
+        rloc += (val * val);
+    }
+    return rloc;
+}
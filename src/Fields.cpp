@@ -1,19 +1,24 @@
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 
 #include "Communication.hpp"
+#include "Discretization.hpp"
 #include "Fields.hpp"
 
 Fields::Fields(double nu, double dt, double tau, int size_x, int size_y, double UI, double VI, double PI, double alpha, double beta, double GX, double GY, double TI)
     : _nu(nu), _dt(dt), _tau(tau), _alpha(alpha),  _beta(beta), _gx(GX), _gy(GY) {
-    _U = Matrix<double>(size_x + 2, size_y + 2, UI);
-    _V = Matrix<double>(size_x + 2, size_y + 2, VI);
+    _U = Matrix<Real>(size_x + 2, size_y + 2, UI);
+    _V = Matrix<Real>(size_x + 2, size_y + 2, VI);
     _P = Matrix<double>(size_x + 2, size_y + 2, PI);
-    _T = Matrix<double>(size_x + 2, size_y + 2, TI);
-    _F = Matrix<double>(size_x + 2, size_y + 2, 0.0);
-    _G = Matrix<double>(size_x + 2, size_y + 2, 0.0);
+    _T = Matrix<Real>(size_x + 2, size_y + 2, TI);
+    _T_next = Matrix<Real>(size_x + 2, size_y + 2, TI);
+    _F = Matrix<Real>(size_x + 2, size_y + 2, 0.0);
+    _G = Matrix<Real>(size_x + 2, size_y + 2, 0.0);
     _RS = Matrix<double>(size_x + 2, size_y + 2, 0.0);
+    _u_max = _U.max_abs_value();
+    _v_max = _V.max_abs_value();
 }
 
 void Fields::printMatrix(Grid &grid) {
@@ -115,69 +120,187 @@ void Fields::printBorders(Grid &grid) {
     
 }
 
-void Fields::calculate_fluxes(Grid &grid) {
+namespace {
+/// Rows per block of the fused flux kernel, the first row of every block gets its right hand side afterwards
+constexpr int flux_block_rows = 32;
 
-    for (int i = 1; i <= grid.itermax_x() - 1; i++) {
-        for (int j = 1; j <= grid.size_y(); j++) {
-            _F(i, j) = _U(i, j) +
-                       _dt * (_nu * (Discretization::laplacian(_U, i, j)) - Discretization::convection_u(_U, _V, i, j)) - _beta * _dt/2 * (_T(i,j)+_T(i+1,j)) * _gx;
-        }
-    }
-//    std::cout << my_rank_global << "Calculating flux F" << std::endl;
+/// Right hand side of the pressure equation at storage index c
+double pressure_rhs(const Real *f, const Real *g, int c, int s, double idt, double idx, double idy) {
+    return idt * ((f[c] - f[c - 1]) * idx + (g[c] - g[c - s]) * idy);
+}
+} // namespace
 
-    for (int i = 1; i <= grid.size_x(); i++) {
-        for (int j = 1; j <= grid.itermax_y() - 1; j++) {
-            _G(i, j) = _V(i, j) +
-                       _dt * (_nu * (Discretization::laplacian(_V, i, j)) - Discretization::convection_v(_U, _V, i, j)) - _beta * _dt/2 * (_T(i,j)+_T(i,j+1)) * _gy;
+void Fields::calculate_fluxes(Grid &grid) {
+    double idx = 1.0 / grid.dx();
+    double idy = 1.0 / grid.dy();
+    double idt = 1.0 / _dt;
+    StencilCoefficients coefficients = stencil_coefficients(grid);
+
+    int s = _U.stride();
+    const Real *u = _U.data();
+    const Real *v = _V.data();
+    const Real *t = _T.data();
+    Real *f = _F.data();
+    Real *g = _G.data();
+    double *rs = _RS.data();
+    int size_y = grid.size_y();
+    int last_f = grid.itermax_x() - 1;
+    int last_g_row = grid.itermax_y() - 1;
+    int blocks = (size_y + flux_block_rows - 1) / flux_block_rows;
+    const FluidSpans &spans = grid.fluid_spans();
+    StencilKernels::FluxRow flux_f = _kernels.flux_f;
+    StencilKernels::FluxRow flux_g = _kernels.flux_g;
+
+    // One pass over the fluid spans of the rows computes F, G and the right
+    // hand side, which needs G of the row below. The first row of a block
+    // would take it from another thread and is done after all blocks. The
+    // fluxes on the faces of the solid cells are set by applyFlux.
+#pragma omp parallel
+    {
+#pragma omp for schedule(static)
+        for (int b = 0; b < blocks; ++b) {
+            int first_row = 1 + b * flux_block_rows;
+            int last_row = std::min(size_y, first_row + flux_block_rows - 1);
+            for (int j = first_row; j <= last_row; ++j) {
+                int row = j * s;
+                for (const FluidSpan &span : spans.row(j)) {
+                    flux_f(u + row, v + row, t + row, s, span.first, std::min(span.last, last_f), coefficients,
+                           f + row);
+                    if (j <= last_g_row) {
+                        flux_g(u + row, v + row, t + row, s, span.first, span.last, coefficients, g + row);
+                    }
+                    if (j > first_row or b == 0) {
+#pragma omp simd
+                        for (int i = span.first; i <= span.last; ++i) {
+                            rs[row + i] = pressure_rhs(f, g, row + i, s, idt, idx, idy);
+                        }
+                    }
+                }
+            }
+        }
+#pragma omp for schedule(static)
+        for (int b = 1; b < blocks; ++b) {
+            int j = 1 + b * flux_block_rows;
+            int row = j * s;
+            for (const FluidSpan &span : spans.row(j)) {
+#pragma omp simd
+                for (int i = span.first; i <= span.last; ++i) {
+                    rs[row + i] = pressure_rhs(f, g, row + i, s, idt, idx, idy);
+                }
+            }
         }
     }
-//    std::cout << my_rank_global <<" Calculating flux G" << std::endl;
 }
 
 void Fields::calculate_rs(Grid &grid) {
-
-    for (int i = 1; i <= grid.size_x(); i++) {
-        for (int j = 1; j <= grid.size_y(); j++) {
-            _RS(i, j) = 1 / _dt * ((_F(i, j) - _F(i - 1, j)) / grid.dx() + (_G(i, j) - _G(i, j - 1)) / grid.dy());
-        }
+    int s = _RS.stride();
+    const Real *f = _F.data();
+    const Real *g = _G.data();
+    double *rs = _RS.data();
+    double idt = 1.0 / _dt;
+    double idx = 1.0 / grid.dx();
+    double idy = 1.0 / grid.dy();
+    for (const auto &cell : grid.flux_boundary_cells()) {
+        int c = cell.j() * s + cell.i();
+        rs[c] = pressure_rhs(f, g, c, s, idt, idx, idy);
     }
-//    std::cout << my_rank_global << "Calculating rs" << std::endl;
 }
 
 void Fields::calculate_velocities(Grid &grid) {
-
-    for (int i = 1; i <= grid.itermax_x() - 1; i++) {
-        for (int j = 1; j <= grid.size_y(); j++) {
-            _U(i, j) = _F(i, j) - _dt / grid.dx() * (_P(i + 1, j) - _P(i, j));
+    int s = _U.stride();
+    const Real *f = _F.data();
+    const Real *g = _G.data();
+    const double *p = _P.data();
+    Real *u = _U.data();
+    Real *v = _V.data();
+    int size_x = grid.size_x();
+    int size_y = grid.size_y();
+    int last_u = grid.itermax_x() - 1;
+    int last_v_row = grid.itermax_y() - 1;
+    double dt_dx = _dt / grid.dx();
+    double dt_dy = _dt / grid.dy();
+    const FluidSpans &spans = grid.fluid_spans();
+
+    // The maxima include the faces that are not updated, like Matrix::max_abs_value
+    Real u_max = 0.0;
+    Real v_max = 0.0;
+#pragma omp parallel for schedule(static) reduction(max : u_max, v_max)
+    for (int j = 1; j <= size_y; ++j) {
+        int row = j * s;
+        for (const FluidSpan &span : spans.row(j)) {
+            int last_u_span = std::min(span.last, last_u);
+#pragma omp simd
+            for (int i = span.first; i <= last_u_span; ++i) {
+                u[row + i] = static_cast<Real>(f[row + i] - dt_dx * (p[row + i + 1] - p[row + i]));
+            }
+            if (j <= last_v_row) {
+#pragma omp simd
+                for (int i = span.first; i <= span.last; ++i) {
+                    v[row + i] = static_cast<Real>(g[row + i] - dt_dy * (p[row + i + s] - p[row + i]));
+                }
+            }
         }
-    }
-//    std::cout << my_rank_global << "Calculating velocity U" << std::endl;
-    
-
-    for (int i = 1; i <= grid.size_x(); i++) {
-        for (int j = 1; j <= grid.itermax_y() - 1; j++) {
-            _V(i, j) = _G(i, j) - _dt / grid.dy() * (_P(i, j + 1) - _P(i, j));
+#pragma omp simd reduction(max : u_max, v_max)
+        for (int i = 1; i <= size_x; ++i) {
+            u_max = std::max(u_max, std::abs(u[row + i]));
+            v_max = std::max(v_max, std::abs(v[row + i]));
         }
     }
-//    std::cout << my_rank_global << "Calculating velocity V" << std::endl;
+    _u_max = u_max;
+    _v_max = v_max;
 }
 
 void Fields::calculate_temperature(Grid &grid) {
-    for (int i = 1; i <= grid.size_x(); i++) {
-        for (int j = 1; j <= grid.size_y(); j++){
-            if (grid.cell(i,j).type() == cell_type::FLUID){
-                _T(i, j) = _T(i,j) + _dt * ((_alpha * Discretization::laplacian(_T,i,j)) - Discretization::convection_t(_T,_U,_V,i,j));
-            }
+    int s = _T.stride();
+    int size_x = grid.size_x();
+    int size_y = grid.size_y();
+    const Real *t = _T.data();
+    const Real *u = _U.data();
+    const Real *v = _V.data();
+    const FluidSpans &spans = grid.fluid_spans();
+    Real *t_next = _T_next.data();
+    StencilCoefficients coefficients = stencil_coefficients(grid);
+    StencilKernels::TemperatureRow temperature = _kernels.temperature;
+
+    // Explicit step from the temperatures of the last step into _T_next on the
+    // fluid spans, the other cells and the ghost layer keep their values
+    std::copy(_T.row(0), _T.row(1), _T_next.row(0));
+    std::copy(_T.row(size_y + 1), _T.row(size_y + 1) + s, _T_next.row(size_y + 1));
+#pragma omp parallel for schedule(static)
+    for (int j = 1; j <= size_y; ++j) {
+        int row = j * s;
+        int copied = 0;
+        for (const FluidSpan &span : spans.row(j)) {
+            std::copy(t + row + copied, t + row + span.first, t_next + row + copied);
+            temperature(t + row, u + row, v + row, s, span.first, span.last, coefficients, t_next + row);
+            copied = span.last + 1;
         }
+        std::copy(t + row + copied, t + row + size_x + 2, t_next + row + copied);
     }
+    std::swap(_T, _T_next);
 }
 
+StencilCoefficients Fields::stencil_coefficients(const Grid &grid) const {
+    StencilCoefficients coefficients;
+    coefficients.idx = 1.0 / grid.dx();
+    coefficients.idy = 1.0 / grid.dy();
+    coefficients.gamma = _kernels.gamma;
+    coefficients.nu = _nu;
+    coefficients.alpha = _alpha;
+    coefficients.dt = _dt;
+    coefficients.buoyancy_x = _beta * _dt / 2 * _gx;
+    coefficients.buoyancy_y = _beta * _dt / 2 * _gy;
+    return coefficients;
+}
+
+void Fields::set_kernels(const StencilKernels &kernels) { _kernels = kernels; }
+
 void Fields::calculate_dt(Grid &grid) {
     double dx_2 = grid.dx() * grid.dx();
     double dy_2 = grid.dy() * grid.dy();
 
-    double u_max = _U.max_abs_value();
-    double v_max = _V.max_abs_value();
+    double u_max = _u_max;
+    double v_max = _v_max;
 
     double coefficient = (dx_2 * dy_2) / (dx_2 + dy_2);
     double conv_cond = coefficient / (2 * _nu);
@@ -192,23 +315,70 @@ void Fields::calculate_dt(Grid &grid) {
     _dt = Communication::reduce_min(_dt);
 }
 
+void Fields::store_pressure(double time) {
+    _history_head = (_history_head + 1) % _p_history.size();
+    // the first store places the pages of the slot like the ones of the pressure,
+    // later copies reuse them
+    if (_p_history[_history_head].size() != _P.size()) {
+        _p_history[_history_head] = Matrix<double>(_P.num_cols(), _P.num_rows());
+    }
+    _p_history[_history_head] = _P;
+    _t_history[_history_head] = time;
+    _history_size = std::min(_history_size + 1, static_cast<int>(_p_history.size()));
+}
+
+void Fields::extrapolate_pressure(double time, int order) {
+    int points = std::min(order + 1, _history_size);
+    if (points < 2) {
+        return;
+    }
+
+    // Lagrange weights of the stored fields, newest first
+    std::array<int, 3> index{};
+    std::array<double, 3> weight{};
+    for (int m = 0; m < points; ++m) {
+        index[m] = (_history_head - m + _p_history.size()) % _p_history.size();
+    }
+    for (int m = 0; m < points; ++m) {
+        weight[m] = 1.0;
+        for (int l = 0; l < points; ++l) {
+            if (l != m) {
+                weight[m] *= (time - _t_history[index[l]]) / (_t_history[index[m]] - _t_history[index[l]]);
+            }
+        }
+    }
+
+    int n = _P.size();
+    double *p = _P.data();
+#pragma omp parallel for schedule(static)
+    for (int c = 0; c < n; ++c) {
+        double value = 0.0;
+        for (int m = 0; m < points; ++m) {
+            value += weight[m] * _p_history[index[m]].data()[c];
+        }
+        p[c] = value;
+    }
+}
+
+void Fields::clear_pressure_history() { _history_size = 0; }
+
 double &Fields::p(int i, int j) { return _P(i, j); }
-double &Fields::u(int i, int j) { return _U(i, j); }
-double &Fields::v(int i, int j) { return _V(i, j); }
-double &Fields::f(int i, int j) { return _F(i, j); }
-double &Fields::g(int i, int j) { return _G(i, j); }
+Real &Fields::u(int i, int j) { return _U(i, j); }
+Real &Fields::v(int i, int j) { return _V(i, j); }
+Real &Fields::f(int i, int j) { return _F(i, j); }
+Real &Fields::g(int i, int j) { return _G(i, j); }
 double &Fields::rs(int i, int j) { return _RS(i, j); }
-double &Fields::T(int i, int j) { return _T(i, j); }
+Real &Fields::T(int i, int j) { return _T(i, j); }
 
 
 
 Matrix<double> &Fields::p_matrix() { return _P; }
-Matrix<double> &Fields::u_matrix() { return _U; }
-Matrix<double> &Fields::v_matrix() { return _V; }
-Matrix<double> &Fields::f_matrix() { return _F; }
-Matrix<double> &Fields::g_matrix() { return _G; }
+Matrix<Real> &Fields::u_matrix() { return _U; }
+Matrix<Real> &Fields::v_matrix() { return _V; }
+Matrix<Real> &Fields::f_matrix() { return _F; }
+Matrix<Real> &Fields::g_matrix() { return _G; }
 Matrix<double> &Fields::rs_matrix() { return _RS; }
-Matrix<double> &Fields::t_matrix() { return _T; }
+Matrix<Real> &Fields::t_matrix() { return _T; }
 
 
 double Fields::dt() const { return _dt; }
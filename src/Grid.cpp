@@ -11,8 +11,6 @@ Grid::Grid(std::string geom_name, Domain &domain) {
 
     _domain = domain;
 
-    _cells = Matrix<Cell>(_domain.size_x + 2, _domain.size_y + 2);
-
     if (geom_name.compare("NONE")) {
         std::vector<std::vector<int>> geometry_data(_domain.domain_imax + 2,
                                                     std::vector<int>(_domain.domain_jmax + 2, 0));
@@ -21,6 +19,7 @@ Grid::Grid(std::string geom_name, Domain &domain) {
     } else {
         build_lid_driven_cavity();
     }
+    build_cell_lists();
 }
 
 void Grid::build_lid_driven_cavity() {
@@ -43,40 +42,50 @@ void Grid::build_lid_driven_cavity() {
 
 void Grid::assign_cell_types(std::vector<std::vector<int>> &geometry_data) {
 
-    int i = 0;
-    int j = 0;
+    int nx = _domain.size_x + 2;
+    int ny = _domain.size_y + 2;
+    _types = Matrix<std::uint8_t>(nx, ny);
+    _wall_ids = Matrix<std::uint8_t>(nx, ny);
+    _borders = Matrix<std::uint8_t>(nx, ny);
+
+    auto set_type = [&](int i, int j, cell_type type, int id) {
+        _types(i, j) = static_cast<std::uint8_t>(type);
+        _wall_ids(i, j) = static_cast<std::uint8_t>(id);
+    };
+    auto type = [&](int i, int j) { return static_cast<cell_type>(_types(i, j)); };
 
-    std::vector<Cell *> _temp_fixed_wall_cells;
+    std::vector<Cell> _temp_fixed_wall_cells;
 
+    int j = 0;
     for (int j_geom = _domain.jminb; j_geom < _domain.jmaxb; ++j_geom) {
-        { i = 0; }
+        int i = 0;
         for (int i_geom = _domain.iminb; i_geom < _domain.imaxb; ++i_geom) {
-            if (geometry_data.at(i_geom).at(j_geom) == GeometryIDs::fluid) {
-                _cells(i, j) = Cell(i, j, cell_type::FLUID);
-                if ( not ((i == 0) or (i == _domain.size_x + 1) or (j == 0) or (j == _domain.size_y + 1)) ) {
-                    _fluid_cells.push_back(&_cells(i, j));
+            int id = geometry_data.at(i_geom).at(j_geom);
+            if (id == GeometryIDs::fluid) {
+                set_type(i, j, cell_type::FLUID, 0);
+                if (not((i == 0) or (i == _domain.size_x + 1) or (j == 0) or (j == _domain.size_y + 1))) {
+                    _fluid_cells.emplace_back(i, j, cell_type::FLUID);
                 } // don't add ghost cells to fluid cells
-            } else if (geometry_data.at(i_geom).at(j_geom) == GeometryIDs::moving_wall) {
-                _cells(i, j) = Cell(i, j, cell_type::MOVING_WALL, geometry_data.at(i_geom).at(j_geom));
-                _moving_wall_cells.push_back(&_cells(i, j));
-            } else if (geometry_data.at(i_geom).at(j_geom) == GeometryIDs::fixed_velocity) {
-                _cells(i, j) = Cell(i, j, cell_type::FIXED_VELOCITY, geometry_data.at(i_geom).at(j_geom));
-                _fixed_velocity_cells.push_back(&_cells(i, j));
-            } else if (geometry_data.at(i_geom).at(j_geom) == GeometryIDs::zero_gradient) {
-                _cells(i, j) = Cell(i, j, cell_type::ZERO_GRADIENT, geometry_data.at(i_geom).at(j_geom));
-                _zero_gradient_cells.push_back(&_cells(i, j));
+            } else if (id == GeometryIDs::moving_wall) {
+                set_type(i, j, cell_type::MOVING_WALL, id);
+                _moving_wall_cells.emplace_back(i, j, cell_type::MOVING_WALL, id);
+            } else if (id == GeometryIDs::fixed_velocity) {
+                set_type(i, j, cell_type::FIXED_VELOCITY, id);
+                _fixed_velocity_cells.emplace_back(i, j, cell_type::FIXED_VELOCITY, id);
+            } else if (id == GeometryIDs::zero_gradient) {
+                set_type(i, j, cell_type::ZERO_GRADIENT, id);
+                _zero_gradient_cells.emplace_back(i, j, cell_type::ZERO_GRADIENT, id);
                 // determine fixed walls in the next sections by checking if neighbour is fluid
-            } else if (geometry_data.at(i_geom).at(j_geom) == GeometryIDs::hot_wall) {
-                _cells(i, j) = Cell(i, j, cell_type::FIXED_WALL, geometry_data.at(i_geom).at(j_geom));
-                _hot_wall_cells.push_back(&_cells(i, j));
-            } else if (geometry_data.at(i_geom).at(j_geom) == GeometryIDs::cold_wall) {
-                _cells(i, j) = Cell(i, j, cell_type::FIXED_WALL, geometry_data.at(i_geom).at(j_geom));
-                _cold_wall_cells.push_back(&_cells(i, j));
+            } else if (id == GeometryIDs::hot_wall) {
+                set_type(i, j, cell_type::FIXED_WALL, id);
+                _hot_wall_cells.emplace_back(i, j, cell_type::FIXED_WALL, id);
+            } else if (id == GeometryIDs::cold_wall) {
+                set_type(i, j, cell_type::FIXED_WALL, id);
+                _cold_wall_cells.emplace_back(i, j, cell_type::FIXED_WALL, id);
             } else {
                 // Outer walls and inner obstacles
-                _cells(i, j) = Cell(i, j, cell_type::FIXED_WALL, geometry_data.at(i_geom).at(j_geom));
-                _temp_fixed_wall_cells.push_back(&_cells(i, j));
-                //                _fixed_wall_cells.push_back(&_cells(i, j));
+                set_type(i, j, cell_type::FIXED_WALL, id);
+                _temp_fixed_wall_cells.emplace_back(i, j, cell_type::FIXED_WALL, id);
             }
             ++i;
         }
@@ -84,219 +93,92 @@ void Grid::assign_cell_types(std::vector<std::vector<int>> &geometry_data) {
     }
 
     // Ghost cells
-    for (int i = 0; i < _domain.size_x + 2; ++i) {
-        _ghost_cells.push_back(&_cells(i, 0));
-        _ghost_cells.push_back(&_cells(i, _domain.size_y + 1));
+    for (int i = 0; i < nx; ++i) {
+        _ghost_cells.emplace_back(i, 0, type(i, 0));
+        _ghost_cells.emplace_back(i, ny - 1, type(i, ny - 1));
     }
-    for (int j = 0; j < _domain.size_y + 2; ++j) {
-        _ghost_cells.push_back(&_cells(0, j));
-        _ghost_cells.push_back(&_cells(_domain.size_x + 1, j));
+    for (int j = 0; j < ny; ++j) {
+        _ghost_cells.emplace_back(0, j, type(0, j));
+        _ghost_cells.emplace_back(nx - 1, j, type(nx - 1, j));
     }
 
+    // Determine fixed walls and inner obstacles. A ghost cell is an inner
+    // obstacle if its inner neighbour is a wall, any other wall cell if it has
+    // no fluid neighbour. The types change in order, so earlier inner
+    // obstacles no longer count as walls.
+    for (const auto &cell : _temp_fixed_wall_cells) {
+        int i = cell.i();
+        int j = cell.j();
 
-    // Determine fixed walls and inner obstacles
-
-    for (auto cell : _temp_fixed_wall_cells) {
-        i = cell->i();
-        j = cell->j();
-
-
+        bool inner_obstacle;
         if (i == 0) {
-            if (_cells(i + 1, j).type() == cell_type::FIXED_WALL) {
-                _inner_obstacle_cells.push_back(cell);
-                _cells(i, j) = Cell(i, j, cell_type::INNER_OBSTACLE);
-                continue;
-            } else {
-                _fixed_wall_cells.push_back(cell);
-                continue;
-            }
-        } else if (i == _domain.size_x + 1) {
-            if (_cells(i - 1, j).type() == cell_type::FIXED_WALL) {
-                _inner_obstacle_cells.push_back(cell);
-                _cells(i, j) = Cell(i, j, cell_type::INNER_OBSTACLE);
-                continue;
-            } else {
-                _fixed_wall_cells.push_back(cell);
-                continue;
-            }
-
+            inner_obstacle = type(i + 1, j) == cell_type::FIXED_WALL;
+        } else if (i == nx - 1) {
+            inner_obstacle = type(i - 1, j) == cell_type::FIXED_WALL;
         } else if (j == 0) {
-            if (_cells(i, j + 1).type() == cell_type::FIXED_WALL) {
-                _inner_obstacle_cells.push_back(cell);
-                _cells(i, j) = Cell(i, j, cell_type::INNER_OBSTACLE);
-                continue;
-            } else {
-                _fixed_wall_cells.push_back(cell);
-                continue;
-            }
-        } else if (j == _domain.size_y + 1) {
-            if (_cells(i, j - 1).type() == cell_type::FIXED_WALL) {
-                _inner_obstacle_cells.push_back(cell);
-                _cells(i, j) = Cell(i, j, cell_type::INNER_OBSTACLE);
-                continue;
-            } else {
-                _fixed_wall_cells.push_back(cell);
-                continue;
-            }
+            inner_obstacle = type(i, j + 1) == cell_type::FIXED_WALL;
+        } else if (j == ny - 1) {
+            inner_obstacle = type(i, j - 1) == cell_type::FIXED_WALL;
+        } else {
+            inner_obstacle = type(i + 1, j) != cell_type::FLUID and type(i - 1, j) != cell_type::FLUID and
+                             type(i, j + 1) != cell_type::FLUID and type(i, j - 1) != cell_type::FLUID;
         }
 
-        if (_cells(i + 1, j).type() == cell_type::FLUID) {
-            _fixed_wall_cells.push_back(cell);
-            continue;
-        }
-        if (_cells(i - 1, j).type() == cell_type::FLUID) {
-            _fixed_wall_cells.push_back(cell);
-            continue;
-        }
-        if (_cells(i, j + 1).type() == cell_type::FLUID) {
+        if (inner_obstacle) {
+            set_type(i, j, cell_type::INNER_OBSTACLE, 0);
+            _inner_obstacle_cells.emplace_back(i, j, cell_type::INNER_OBSTACLE);
+        } else {
             _fixed_wall_cells.push_back(cell);
-            continue;
         }
-        if (_cells(i, j - 1).type() == cell_type::FLUID) {
-            _fixed_wall_cells.push_back(cell);
-            continue;
-        }
-        _inner_obstacle_cells.push_back(cell);
-        _cells(i, j) = Cell(i, j, cell_type::INNER_OBSTACLE);
     }
 
-
-    // Corner cell neighbour assigment
-    // Bottom-Left Corner
-    i = 0;
-    j = 0;
-    _cells(i, j).set_neighbour(&_cells(i, j + 1), border_position::TOP);
-    _cells(i, j).set_neighbour(&_cells(i + 1, j), border_position::RIGHT);
-    if (_cells(i, j).neighbour(border_position::TOP)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::TOP);
-    }
-    if (_cells(i, j).neighbour(border_position::RIGHT)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::RIGHT);
-    }
-    // Top-Left Corner
-    i = 0;
-    j = _domain.size_y + 1;
-    _cells(i, j).set_neighbour(&_cells(i, j - 1), border_position::BOTTOM);
-    _cells(i, j).set_neighbour(&_cells(i + 1, j), border_position::RIGHT);
-    if (_cells(i, j).neighbour(border_position::BOTTOM)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::BOTTOM);
-    }
-    if (_cells(i, j).neighbour(border_position::RIGHT)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::RIGHT);
-    }
-
-    // Top-Right Corner
-    i = _domain.size_x + 1;
-    j = Grid::_domain.size_y + 1;
-    _cells(i, j).set_neighbour(&_cells(i, j - 1), border_position::BOTTOM);
-    _cells(i, j).set_neighbour(&_cells(i - 1, j), border_position::LEFT);
-    if (_cells(i, j).neighbour(border_position::BOTTOM)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::BOTTOM);
-    }
-    if (_cells(i, j).neighbour(border_position::LEFT)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::LEFT);
-    }
-
-    // Bottom-Right Corner
-    i = Grid::_domain.size_x + 1;
-    j = 0;
-    _cells(i, j).set_neighbour(&_cells(i, j + 1), border_position::TOP);
-    _cells(i, j).set_neighbour(&_cells(i - 1, j), border_position::LEFT);
-    if (_cells(i, j).neighbour(border_position::TOP)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::TOP);
-    }
-    if (_cells(i, j).neighbour(border_position::LEFT)->type() == cell_type::FLUID) {
-        _cells(i, j).add_border(border_position::LEFT);
-    }
-    // Bottom cells
-    j = 0;
-    for (int i = 1; i < _domain.size_x + 1; ++i) {
-        _cells(i, j).set_neighbour(&_cells(i + 1, j), border_position::RIGHT);
-        _cells(i, j).set_neighbour(&_cells(i - 1, j), border_position::LEFT);
-        _cells(i, j).set_neighbour(&_cells(i, j + 1), border_position::TOP);
-        if (_cells(i, j).neighbour(border_position::RIGHT)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::RIGHT);
-        }
-        if (_cells(i, j).neighbour(border_position::LEFT)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::LEFT);
-        }
-        if (_cells(i, j).neighbour(border_position::TOP)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::TOP);
-        }
-    }
-
-    // Top Cells
-    j = Grid::_domain.size_y + 1;
-
-    for (int i = 1; i < _domain.size_x + 1; ++i) {
-        _cells(i, j).set_neighbour(&_cells(i + 1, j), border_position::RIGHT);
-        _cells(i, j).set_neighbour(&_cells(i - 1, j), border_position::LEFT);
-        _cells(i, j).set_neighbour(&_cells(i, j - 1), border_position::BOTTOM);
-        if (_cells(i, j).neighbour(border_position::RIGHT)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::RIGHT);
-        }
-        if (_cells(i, j).neighbour(border_position::LEFT)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::LEFT);
-        }
-        if (_cells(i, j).neighbour(border_position::BOTTOM)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::BOTTOM);
+    // Borders to fluid cells, for all cells of the ghost layer and the other
+    // cells except fluid. The neighbours follow from the indices.
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            bool ghost = i == 0 or j == 0 or i == nx - 1 or j == ny - 1;
+            if (not ghost and type(i, j) == cell_type::FLUID) {
+                continue;
+            }
+            std::uint8_t borders = 0;
+            if (j < ny - 1 and type(i, j + 1) == cell_type::FLUID) {
+                borders |= Cell::border_bit(border_position::TOP);
+            }
+            if (j > 0 and type(i, j - 1) == cell_type::FLUID) {
+                borders |= Cell::border_bit(border_position::BOTTOM);
+            }
+            if (i > 0 and type(i - 1, j) == cell_type::FLUID) {
+                borders |= Cell::border_bit(border_position::LEFT);
+            }
+            if (i < nx - 1 and type(i + 1, j) == cell_type::FLUID) {
+                borders |= Cell::border_bit(border_position::RIGHT);
+            }
+            _borders(i, j) = borders;
         }
     }
 
-    // Left Cells
-    i = 0;
-    for (int j = 1; j < _domain.size_y + 1; ++j) {
-        _cells(i, j).set_neighbour(&_cells(i + 1, j), border_position::RIGHT);
-        _cells(i, j).set_neighbour(&_cells(i, j - 1), border_position::BOTTOM);
-        _cells(i, j).set_neighbour(&_cells(i, j + 1), border_position::TOP);
-        if (_cells(i, j).neighbour(border_position::RIGHT)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::RIGHT);
-        }
-        if (_cells(i, j).neighbour(border_position::BOTTOM)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::BOTTOM);
-        }
-        if (_cells(i, j).neighbour(border_position::TOP)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::TOP);
-        }
-    }
-    // Right Cells
-    i = Grid::_domain.size_x + 1;
-    for (int j = 1; j < _domain.size_y + 1; ++j) {
-        _cells(i, j).set_neighbour(&_cells(i - 1, j), border_position::LEFT);
-        _cells(i, j).set_neighbour(&_cells(i, j - 1), border_position::BOTTOM);
-        _cells(i, j).set_neighbour(&_cells(i, j + 1), border_position::TOP);
-        if (_cells(i, j).neighbour(border_position::LEFT)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::LEFT);
-        }
-        if (_cells(i, j).neighbour(border_position::BOTTOM)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::BOTTOM);
-        }
-        if (_cells(i, j).neighbour(border_position::TOP)->type() == cell_type::FLUID) {
-            _cells(i, j).add_border(border_position::TOP);
+    // The cells of the lists get their final type and borders
+    for (auto *cells : {&_fluid_cells, &_fixed_wall_cells, &_moving_wall_cells, &_fixed_velocity_cells,
+                        &_zero_gradient_cells, &_inner_obstacle_cells, &_cold_wall_cells, &_hot_wall_cells,
+                        &_ghost_cells}) {
+        for (auto &cell : *cells) {
+            cell = this->cell(cell.i(), cell.j());
         }
     }
+}
 
-    // Inner cells
-    for (int i = 1; i < _domain.size_x + 1; ++i) {
-        for (int j = 1; j < _domain.size_y + 1; ++j) {
-            _cells(i, j).set_neighbour(&_cells(i + 1, j), border_position::RIGHT);
-            _cells(i, j).set_neighbour(&_cells(i - 1, j), border_position::LEFT);
-            _cells(i, j).set_neighbour(&_cells(i, j + 1), border_position::TOP);
-            _cells(i, j).set_neighbour(&_cells(i, j - 1), border_position::BOTTOM);
-
-            if (_cells(i, j).type() != cell_type::FLUID) {
-                if (_cells(i, j).neighbour(border_position::LEFT)->type() == cell_type::FLUID) {
-                    _cells(i, j).add_border(border_position::LEFT);
-                }
-                if (_cells(i, j).neighbour(border_position::RIGHT)->type() == cell_type::FLUID) {
-                    _cells(i, j).add_border(border_position::RIGHT);
-                }
-                if (_cells(i, j).neighbour(border_position::BOTTOM)->type() == cell_type::FLUID) {
-                    _cells(i, j).add_border(border_position::BOTTOM);
-                }
-                if (_cells(i, j).neighbour(border_position::TOP)->type() == cell_type::FLUID) {
-                    _cells(i, j).add_border(border_position::TOP);
-                }
+void Grid::build_cell_lists() {
+    _fluid_spans = FluidSpans(_types);
+
+    // applyFlux sets the fluxes on the faces of the cells with borders
+    auto sets_fluxes = [&](int i, int j) {
+        return static_cast<cell_type>(_types(i, j)) != cell_type::FLUID and _borders(i, j) != 0;
+    };
+    for (int j = 1; j <= _domain.size_y; ++j) {
+        for (int i = 1; i <= _domain.size_x; ++i) {
+            if (i == 1 or j == 1 or sets_fluxes(i, j) or sets_fluxes(i - 1, j) or sets_fluxes(i + 1, j) or
+                sets_fluxes(i, j - 1) or sets_fluxes(i, j + 1)) {
+                _flux_boundary_cells.push_back(cell(i, j));
             }
         }
     }
@@ -342,7 +224,9 @@ int Grid::size_y() const { return _domain.size_y; }
 int Grid::itermax_x() const { return _domain.itermax_x; }
 int Grid::itermax_y() const { return _domain.itermax_y; }
 
-Cell Grid::cell(int i, int j) const { return _cells(i, j); }
+Cell Grid::cell(int i, int j) const {
+    return Cell(i, j, static_cast<cell_type>(_types(i, j)), _wall_ids(i, j), _borders(i, j));
+}
 
 double Grid::dx() const { return _domain.dx; }
 
@@ -350,20 +234,48 @@ double Grid::dy() const { return _domain.dy; }
 
 const Domain &Grid::domain() const { return _domain; }
 
-const std::vector<Cell *> &Grid::fluid_cells() const { return _fluid_cells; }
+const std::vector<Cell> &Grid::fluid_cells() const { return _fluid_cells; }
+
+const std::vector<Cell> &Grid::fixed_wall_cells() const { return _fixed_wall_cells; }
 
-const std::vector<Cell *> &Grid::fixed_wall_cells() const { return _fixed_wall_cells; }
+const std::vector<Cell> &Grid::moving_wall_cells() const { return _moving_wall_cells; }
 
-const std::vector<Cell *> &Grid::moving_wall_cells() const { return _moving_wall_cells; }
+const std::vector<Cell> &Grid::fixed_velocity_cells() const { return _fixed_velocity_cells; }
 
-const std::vector<Cell *> &Grid::fixed_velocity_cells() const { return _fixed_velocity_cells; }
+const std::vector<Cell> &Grid::zero_gradient_cells() const { return _zero_gradient_cells; }
 
-const std::vector<Cell *> &Grid::zero_gradient_cells() const { return _zero_gradient_cells; }
+const std::vector<Cell> &Grid::inner_obstacle_cells() const { return _inner_obstacle_cells; }
 
-const std::vector<Cell *> &Grid::inner_obstacle_cells() const { return _inner_obstacle_cells; }
+const std::vector<Cell> &Grid::hot_wall_cells() const { return _hot_wall_cells; }
 
-const std::vector<Cell *> &Grid::hot_wall_cells() const { return _hot_wall_cells; }
+const std::vector<Cell> &Grid::cold_wall_cells() const { return _cold_wall_cells; }
 
-const std::vector<Cell *> &Grid::cold_wall_cells() const { return _cold_wall_cells; }
+const std::vector<Cell> &Grid::ghost_cells() const { return _ghost_cells; }
 
-const std::vector<Cell *> &Grid::ghost_cells() const { return _ghost_cells; }
+const std::vector<Cell> &Grid::flux_boundary_cells() const { return _flux_boundary_cells; }
+
+const FluidSpans &Grid::fluid_spans() const { return _fluid_spans; }
+
+FluidSpans::FluidSpans(const Matrix<std::uint8_t> &types) {
+    int nx = types.num_cols();
+    int ny = types.num_rows();
+    auto fluid = [&](int i, int j) { return static_cast<cell_type>(types(i, j)) == cell_type::FLUID; };
+
+    _row_start.assign(ny + 1, 0);
+    for (int j = 1; j < ny - 1; ++j) {
+        _row_start[j] = _spans.size();
+        int i = 1;
+        while (i < nx - 1) {
+            if (not fluid(i, j)) {
+                ++i;
+                continue;
+            }
+            int first = i;
+            while (i < nx - 1 and fluid(i, j)) {
+                ++i;
+            }
+            _spans.push_back({first, i - 1});
+        }
+    }
+    std::fill(_row_start.begin() + ny - 1, _row_start.end(), static_cast<int>(_spans.size()));
+}
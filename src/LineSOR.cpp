@@ -0,0 +1,156 @@
+#include <algorithm>
+
+#include "Communication.hpp"
+#include "LineSOR.hpp"
+
+LineSOR::LineSOR(double omega, const Grid &grid, bool adaptive) : RelaxationSolver(omega, grid, adaptive), _op(grid) {
+    // The coupling idx2 = 1 / dx^2 is the stronger one for dx < dy
+    _along_x = grid.dx() <= grid.dy();
+
+    int stride = _op.mask().stride();
+    int step = _along_x ? 1 : stride;
+    int num_lines = _along_x ? grid.size_y() : grid.size_x();
+    int line_length = _along_x ? grid.size_x() : grid.size_y();
+    // Global index of the first line, the color of a line is the parity of its global index
+    int first_line = _along_x ? grid.domain().jminb : grid.domain().iminb;
+    const double *mask = _op.mask().data();
+    const double *open = _along_x ? _op.open_x().data() : _op.open_y().data();
+
+    for (int line = 1; line <= num_lines; ++line) {
+        std::vector<Segment> &segments = _segments[(first_line + line) % 2];
+        Segment segment{-1, 0};
+        auto close = [&]() {
+            if (segment.length > 0) {
+                segments.push_back(segment);
+                _max_length = std::max(_max_length, segment.length);
+            }
+            segment = {-1, 0};
+        };
+        for (int k = 1; k <= line_length; ++k) {
+            int c = _along_x ? line * stride + k : k * stride + line;
+            if (mask[c] == 0.0) {
+                close();
+            } else if (segment.length > 0 and open[c - step] > 0.0) {
+                segment.length += 1;
+            } else {
+                close();
+                segment = {c, 1};
+            }
+        }
+        close();
+    }
+
+    // Lines cut by the decomposition are relaxed by the processes with even
+    // position along the lines first, simultaneous over-relaxation of both
+    // parts with the old values of each other diverges
+    auto neighbours = Communication::get_neighbours();
+    bool cut = _along_x ? neighbours[LEFT] != MPI_PROC_NULL or neighbours[RIGHT] != MPI_PROC_NULL
+                        : neighbours[DOWN] != MPI_PROC_NULL or neighbours[UP] != MPI_PROC_NULL;
+    _ordered = Communication::reduce_max(cut ? 1.0 : 0.0) > 0.0;
+    _phase = my_coords_global[_along_x ? 0 : 1] % 2;
+
+    int size = _op.mask().size();
+    _link_start.assign(size + 1, 0);
+    for (const auto &link : _op.corner_links()) {
+        _link_start[link.cell + 1] += 1;
+    }
+    for (int c = 0; c < size; ++c) {
+        _link_start[c + 1] += _link_start[c];
+    }
+    _link_neighbour.resize(_op.corner_links().size());
+    std::vector<int> next(_link_start.begin(), _link_start.end() - 1);
+    for (const auto &link : _op.corner_links()) {
+        _link_neighbour[next[link.cell]++] = link.neighbour;
+    }
+}
+
+double LineSOR::sweep(Matrix<double> &P, const Matrix<double> &RS, int color) {
+    int stride = P.stride();
+    int step = _along_x ? 1 : stride;
+    int cross = _along_x ? stride : 1;
+    double along = _along_x ? _op.idx2() : _op.idy2();
+    double across = _along_x ? _op.idy2() : _op.idx2();
+    double corner_weight = _op.corner_weight();
+    double omega = _omega;
+
+    double *p = P.data();
+    const double *rs = RS.data();
+    const double *diag = _op.diag().data();
+    const double *open_along = _along_x ? _op.open_x().data() : _op.open_y().data();
+    const double *open_across = _along_x ? _op.open_y().data() : _op.open_x().data();
+    const std::vector<Segment> &segments = _segments[color];
+    int num_segments = segments.size();
+
+    double rloc = 0.0;
+#pragma omp parallel reduction(+ : rloc)
+    {
+        std::vector<double> upper(_max_length);
+        std::vector<double> rhs(_max_length);
+#pragma omp for schedule(static)
+        for (int s = 0; s < num_segments; ++s) {
+            int first = segments[s].first;
+            int length = segments[s].length;
+
+            // A p = -RS, the couplings to cells outside the segment go to the right hand side
+            for (int k = 0; k < length; ++k) {
+                int c = first + k * step;
+                double b = -rs[c] + across * (open_across[c - cross] * p[c - cross] + open_across[c] * p[c + cross]);
+                for (int l = _link_start[c]; l < _link_start[c + 1]; ++l) {
+                    b += corner_weight * p[_link_neighbour[l]];
+                }
+                double inner = diag[c] * p[c];
+                if (k > 0) {
+                    inner -= along * p[c - step];
+                } else {
+                    b += along * open_along[c - step] * p[c - step];
+                }
+                if (k < length - 1) {
+                    inner -= along * p[c + step];
+                } else {
+                    b += along * open_along[c] * p[c + step];
+                }
+                rhs[k] = b;
+                rloc += (b - inner) * (b - inner);
+            }
+
+            // Thomas algorithm with the off-diagonal -along. A segment without
+            // any other coupling is singular and gets its last pivot replaced.
+            for (int k = 0; k < length; ++k) {
+                int c = first + k * step;
+                double pivot = diag[c] + (k > 0 ? along * upper[k - 1] : 0.0);
+                if (pivot <= 1e-10 * diag[c]) {
+                    pivot = diag[c];
+                }
+                upper[k] = -along / pivot;
+                rhs[k] = (rhs[k] + (k > 0 ? along * rhs[k - 1] : 0.0)) / pivot;
+            }
+            for (int k = length - 2; k >= 0; --k) {
+                rhs[k] -= upper[k] * rhs[k + 1];
+            }
+
+            for (int k = 0; k < length; ++k) {
+                int c = first + k * step;
+                p[c] += omega * (rhs[k] - p[c]);
+            }
+        }
+    }
+    return rloc;
+}
+
+double LineSOR::solve(Fields &field, Grid &, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    double rloc = 0.0;
+    int phases = _ordered ? 2 : 1;
+    for (int color = 0; color < 2; ++color) {
+        for (int phase = 0; phase < phases; ++phase) {
+            if (phase == _phase or not _ordered) {
+                rloc += sweep(field.p_matrix(), field.rs_matrix(), color);
+            }
+            Communication::communicate(field.p_matrix());
+        }
+    }
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    return rloc;
+}
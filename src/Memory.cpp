@@ -0,0 +1,162 @@
+#include "Memory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+HugePages Memory::_policy = HugePages::Transparent;
+bool Memory::_explicit_failed = false;
+
+namespace {
+/// Size of a huge page, allocations of at least this size are mapped directly
+constexpr std::size_t huge_page = std::size_t(2) << 20;
+
+bool mapped(std::size_t bytes) { return bytes >= huge_page; }
+
+/// Length of the mapping of an allocation, whole huge pages
+std::size_t mapped_size(std::size_t bytes) { return (bytes + huge_page - 1) / huge_page * huge_page; }
+} // namespace
+
+void Memory::set_huge_pages(HugePages policy) { _policy = policy; }
+
+HugePages Memory::huge_pages_from_string(const std::string &name) {
+    if (name == "none") {
+        return HugePages::None;
+    }
+    if (name == "explicit") {
+        return HugePages::Explicit;
+    }
+    if (name != "transparent") {
+        std::cerr << "Unknown huge_pages " << name << ", using transparent" << std::endl;
+    }
+    return HugePages::Transparent;
+}
+
+void *Memory::allocate(std::size_t bytes, std::size_t alignment) {
+#ifdef __linux__
+    if (mapped(bytes)) {
+        std::size_t size = mapped_size(bytes);
+        if (_policy == HugePages::Explicit) {
+            void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (data != MAP_FAILED) {
+                return data;
+            }
+            _explicit_failed = true;
+        }
+        // One huge page more is mapped and both ends are trimmed, so the range
+        // is aligned to huge pages and can be backed by them completely
+        void *raw = mmap(nullptr, size + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        auto begin = reinterpret_cast<std::uintptr_t>(raw);
+        auto aligned = (begin + huge_page - 1) / huge_page * huge_page;
+        if (aligned > begin) {
+            munmap(raw, aligned - begin);
+        }
+        std::size_t tail = begin + size + huge_page - (aligned + size);
+        if (tail > 0) {
+            munmap(reinterpret_cast<void *>(aligned + size), tail);
+        }
+        void *data = reinterpret_cast<void *>(aligned);
+        if (_policy != HugePages::None) {
+            madvise(data, size, MADV_HUGEPAGE);
+        }
+        return data;
+    }
+#endif
+    return ::operator new(bytes, std::align_val_t(alignment));
+}
+
+void Memory::deallocate(void *data, std::size_t bytes, std::size_t alignment) {
+#ifdef __linux__
+    if (mapped(bytes)) {
+        munmap(data, mapped_size(bytes));
+        return;
+    }
+#endif
+    ::operator delete(data, std::align_val_t(alignment));
+}
+
+std::string Memory::placement(const void *data, std::size_t bytes) {
+#ifdef __linux__
+    // At most this many pages are queried for their node
+    constexpr std::size_t max_samples = 4096;
+
+    std::ostringstream out;
+    auto begin = reinterpret_cast<std::uintptr_t>(data);
+
+    // Page size and huge pages of the mapping containing the range, adjacent
+    // mappings with the same properties are merged by the kernel
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inside = false;
+    long size_kb = 0;
+    long kernel_page_kb = 0;
+    long huge_kb = 0;
+    while (std::getline(smaps, line)) {
+        unsigned long from = 0;
+        unsigned long to = 0;
+        if (std::sscanf(line.c_str(), "%lx-%lx", &from, &to) == 2) {
+            if (inside) {
+                break;
+            }
+            inside = from <= begin and begin < to;
+        } else if (inside) {
+            std::sscanf(line.c_str(), "Size: %ld kB", &size_kb);
+            std::sscanf(line.c_str(), "KernelPageSize: %ld kB", &kernel_page_kb);
+            std::sscanf(line.c_str(), "AnonHugePages: %ld kB", &huge_kb);
+        }
+    }
+    if (kernel_page_kb >= 2048) {
+        out << kernel_page_kb / 1024 << " MB pages (explicit)";
+    } else {
+        out << kernel_page_kb << " kB pages, " << (size_kb > 0 ? 100 * huge_kb / size_kb : 0)
+            << "% in transparent huge pages";
+    }
+    if (_explicit_failed) {
+        out << " (no explicit huge pages available)";
+    }
+
+    // Node of a sample of the pages, negative for pages not touched yet
+    long page = sysconf(_SC_PAGESIZE);
+    std::uintptr_t first = begin / page * page;
+    std::size_t count = (begin + bytes - first + page - 1) / page;
+    std::size_t step = std::max<std::size_t>(1, count / max_samples);
+    std::vector<void *> pages;
+    for (std::size_t k = 0; k < count; k += step) {
+        pages.push_back(reinterpret_cast<void *>(first + k * page));
+    }
+    std::vector<int> status(pages.size(), -1);
+    if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0) {
+        out << ", NUMA placement unavailable";
+        return out.str();
+    }
+    std::map<int, std::size_t> nodes;
+    for (int node : status) {
+        nodes[node] += 1;
+    }
+    out << ", pages per NUMA node:";
+    for (const auto &[node, pages_on_node] : nodes) {
+        out << " " << (node >= 0 ? std::to_string(node) : "none") << ": " << 100 * pages_on_node / status.size()
+            << "%";
+    }
+    return out.str();
+#else
+    (void)data;
+    (void)bytes;
+    return "page placement unknown";
+#endif
+}
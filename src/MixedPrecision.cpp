@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Communication.hpp"
+#include "Discretization.hpp"
+#include "MixedPrecision.hpp"
+#include "PoissonOperator.hpp"
+
+namespace {
+/// Reduction of the residual by the inner sweeps of one refinement step, well above the accuracy of float
+constexpr double inner_reduction = 1e-3;
+/// Sweeps of one refinement step at most, after which the residual is checked in double
+constexpr int refinement_sweeps = 50;
+} // namespace
+
+MixedPrecisionSOR::MixedPrecisionSOR(double omega, const Grid &grid) : PressureSolver(grid), _omega(omega) {
+    PoissonOperator op(grid);
+    _idx2 = op.idx2();
+    _idy2 = op.idy2();
+    _parity = (grid.domain().iminb + grid.domain().jminb) % 2;
+    _spans = grid.fluid_spans();
+
+    int nx = grid.size_x() + 2;
+    int ny = grid.size_y() + 2;
+    for (int color = 0; color < 2; ++color) {
+        _inv_diag[color] = Matrix<float>(nx, ny, 0.0);
+    }
+    for (const auto &currentCell : grid.fluid_cells()) {
+        int i = currentCell.i();
+        int j = currentCell.j();
+        _inv_diag[(i + j + _parity) % 2](i, j) = static_cast<float>(op.inv_diag()(i, j));
+    }
+
+    // Cells with corner links are taken out of the vectorized sweep and relaxed
+    // with their links afterwards. Both cells of a link have the same color.
+    _corner_weight = op.corner_weight();
+    for (const auto &link : op.corner_links()) {
+        int i = link.cell % op.mask().stride();
+        int j = link.cell / op.mask().stride();
+        auto &linked = _linked[(i + j + _parity) % 2];
+        auto cell = std::find_if(linked.begin(), linked.end(),
+                                 [&](const LinkedCell &candidate) { return candidate.cell == link.cell; });
+        if (cell == linked.end()) {
+            linked.push_back({link.cell, static_cast<float>(op.inv_diag()(i, j)), {}});
+            cell = linked.end() - 1;
+        }
+        cell->neighbours.push_back(link.neighbour);
+        _inv_diag[(i + j + _parity) % 2](i, j) = 0.0f;
+    }
+    _r = Matrix<float>(nx, ny, 0.0);
+    _e = Matrix<float>(nx, ny, 0.0);
+}
+
+double MixedPrecisionSOR::solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    double rloc = residual(field, grid);
+    correct(inner_reduction * std::sqrt(Communication::reduce_sum(rloc) / _global_cells), 0.0, refinement_sweeps);
+    update(field, grid, boundaries);
+    return rloc;
+}
+
+double MixedPrecisionSOR::solve_system(Fields &field, Grid &grid,
+                                       const std::vector<std::unique_ptr<Boundary>> &boundaries, double tolerance,
+                                       int max_iter, int &iter) {
+    // the pressure may have been replaced by an extrapolated guess
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    iter = 0;
+    _steps = 0;
+    double res = std::sqrt(Communication::reduce_sum(residual(field, grid)) / _global_cells);
+    while (res > tolerance and iter < max_iter) {
+        iter += correct(inner_reduction * res, tolerance, std::min(refinement_sweeps, max_iter - iter));
+        update(field, grid, boundaries);
+        _steps += 1;
+        res = std::sqrt(Communication::reduce_sum(residual(field, grid)) / _global_cells);
+    }
+    return res;
+}
+
+std::string MixedPrecisionSOR::statistics() const { return "\tRefinements: " + std::to_string(_steps); }
+
+double MixedPrecisionSOR::residual(Fields &field, const Grid &grid) {
+    double rloc = 0.0;
+    for (const auto &currentCell : grid.fluid_cells()) {
+        int i = currentCell.i();
+        int j = currentCell.j();
+
+        double val = Discretization::laplacian(field.p_matrix(), i, j) - field.rs(i, j);
+        _r(i, j) = static_cast<float>(val);
+        rloc += val * val;
+    }
+    return rloc;
+}
+
+int MixedPrecisionSOR::correct(double target, double tolerance, int max_sweeps) {
+    std::fill(_e.data(), _e.data() + _e.size(), 0.0f);
+
+    double res = std::numeric_limits<double>::max();
+    int sweeps = 0;
+    while (sweeps < max_sweeps and res > target and res > tolerance) {
+        double rloc = 0.0;
+        for (int color = 0; color < 2; ++color) {
+            rloc += sweep(color);
+            Communication::communicate_color(_e, color, _parity);
+        }
+        sweeps += 1;
+
+        if (sweeps % _residual_interval == 0 or sweeps == max_sweeps) {
+            res = std::sqrt(Communication::reduce_sum(rloc) / _global_cells);
+        }
+    }
+    return sweeps;
+}
+
+void MixedPrecisionSOR::update(Fields &field, const Grid &grid,
+                               const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    for (const auto &currentCell : grid.fluid_cells()) {
+        int i = currentCell.i();
+        int j = currentCell.j();
+        field.p(i, j) += _e(i, j);
+    }
+
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+}
+
+double MixedPrecisionSOR::sweep(int color) {
+    float idx2 = static_cast<float>(_idx2);
+    float idy2 = static_cast<float>(_idy2);
+    float omega = static_cast<float>(_omega);
+
+    int ny = _e.num_rows();
+    int stride = _e.stride();
+    float *e = _e.data();
+    const float *r = _r.data();
+
+    // Same in-place scheme as RedBlackSOR::sweep over the cells of the color
+    // in the fluid spans, the linked cells have a zero inverse diagonal here
+    // and are left unchanged
+    double rloc = 0.0;
+#pragma omp parallel for schedule(static) reduction(+ : rloc)
+    for (int j = 1; j < ny - 1; ++j) {
+        float *e_c = _e.row(j);
+        const float *e_s = _e.row(j - 1);
+        const float *e_n = _e.row(j + 1);
+        const float *r_c = _r.row(j);
+        const float *d_c = _inv_diag[color].row(j);
+        for (const FluidSpan &span : _spans.row(j)) {
+#pragma omp simd reduction(+ : rloc)
+            for (int i = span.first + (span.first + j + color + _parity) % 2; i <= span.last; i += 2) {
+                float sum = (e_c[i + 1] + e_c[i - 1]) * idx2 + (e_n[i] + e_s[i]) * idy2 + r_c[i];
+                float delta = d_c[i] > 0.0f ? d_c[i] * sum - e_c[i] : 0.0f;
+                float res = d_c[i] > 0.0f ? delta / d_c[i] : 0.0f;
+                rloc += res * res;
+                e_c[i] += omega * delta;
+            }
+        }
+    }
+
+    float corner_weight = static_cast<float>(_corner_weight);
+    for (const auto &cell : _linked[color]) {
+        int c = cell.cell;
+        float sum = (e[c + 1] + e[c - 1]) * idx2 + (e[c + stride] + e[c - stride]) * idy2 + r[c];
+        for (int neighbour : cell.neighbours) {
+            sum += corner_weight * e[neighbour];
+        }
+        float delta = cell.inv_diag * sum - e[c];
+        float res = delta / cell.inv_diag;
+        rloc += res * res;
+        e[c] += omega * delta;
+    }
+    return rloc;
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "Communication.hpp"
+#include "Multigrid.hpp"
+#include "PoissonOperator.hpp"
+
+namespace {
+/// Range of fine cell indices covered by coarse cell I in one direction
+std::pair<int, int> children(int I, int coarse_size, int fine_size, bool coarsened) {
+    if (not coarsened) {
+        return {I, I};
+    }
+    if (I == 0) {
+        return {0, 0};
+    }
+    if (I == coarse_size + 1) {
+        return {fine_size + 1, fine_size + 1};
+    }
+    return {2 * I - 1, 2 * I};
+}
+} // namespace
+
+Multigrid::Multigrid(const Grid &grid, int cycle_index, int smoothing_steps)
+    : PressureSolver(grid), _cycle_index(cycle_index), _smoothing_steps(smoothing_steps) {
+
+    Level fine;
+    fine.size_x = grid.size_x();
+    fine.size_y = grid.size_y();
+    fine.dx = grid.dx();
+    fine.dy = grid.dy();
+    fine.iminb = grid.domain().iminb;
+    fine.jminb = grid.domain().jminb;
+
+    // The finest level has the faces of the operator used by the Krylov solvers
+    PoissonOperator op(grid);
+    fine.fluid = op.fluid();
+    fine.open_x = op.open_x();
+    fine.open_y = op.open_y();
+    for (auto direction : {DOWN, UP, LEFT, RIGHT}) {
+        fine.outflow[direction] = op.outflow(direction);
+    }
+    _pure_neumann = op.singular();
+
+    finalize_level(fine);
+    _levels.push_back(std::move(fine));
+
+    // All ranks hold the same number of cells, so all of them build the same
+    // number of levels. Only even sizes are coarsened to keep the subdomains aligned.
+    while (true) {
+        const Level &last = _levels.back();
+        bool coarsen_x = last.size_x >= 4 and last.size_x % 2 == 0;
+        bool coarsen_y = last.size_y >= 4 and last.size_y % 2 == 0;
+        if (not coarsen_x and not coarsen_y) {
+            break;
+        }
+        Level coarse = coarsen(last, coarsen_x, coarsen_y);
+        _levels.push_back(std::move(coarse));
+    }
+
+    // SOR with optimal relaxation on the coarsest level
+    int iproc = grid.domain().domain_imax / grid.size_x();
+    int jproc = grid.domain().domain_jmax / grid.size_y();
+    int n = std::max(_levels.back().size_x * iproc, _levels.back().size_y * jproc);
+    _coarse_omega = 2.0 / (1.0 + std::sin(M_PI / n));
+    _coarse_sweeps = 2 * n;
+
+    if (my_rank_global == 0) {
+        std::cout << "Multigrid levels: " << _levels.size() << " (coarsest " << _levels.back().size_x * iproc << " x "
+                  << _levels.back().size_y * jproc << " cells)" << std::endl;
+    }
+}
+
+void Multigrid::finalize_level(Level &level) {
+    int nx = level.size_x + 2;
+    int ny = level.size_y + 2;
+
+    level.p = Matrix<double>(nx, ny, 0.0);
+    level.rhs = Matrix<double>(nx, ny, 0.0);
+    level.res = Matrix<double>(nx, ny, 0.0);
+    level.diag = Matrix<double>(nx, ny, 0.0);
+    level.inv_diag = Matrix<double>(nx, ny, 0.0);
+    for (auto &mask : level.mask) {
+        mask = Matrix<double>(nx, ny, 0.0);
+    }
+
+    double idx2 = 1.0 / (level.dx * level.dx);
+    double idy2 = 1.0 / (level.dy * level.dy);
+
+    for (int j = 1; j < ny - 1; ++j) {
+        for (int i = 1; i < nx - 1; ++i) {
+            if (level.fluid(i, j) == 0.0) {
+                continue;
+            }
+            double diag = idx2 * (level.open_x(i - 1, j) + level.open_x(i, j) +
+                                  2.0 * (level.outflow[LEFT](i, j) + level.outflow[RIGHT](i, j))) +
+                          idy2 * (level.open_y(i, j - 1) + level.open_y(i, j) +
+                                  2.0 * (level.outflow[DOWN](i, j) + level.outflow[UP](i, j)));
+            if (diag <= 0.0) {
+                continue;
+            }
+            level.diag(i, j) = diag;
+            level.inv_diag(i, j) = 1.0 / diag;
+            level.mask[(i + j + level.iminb + level.jminb) % 2](i, j) = 1.0;
+        }
+    }
+}
+
+Multigrid::Level Multigrid::coarsen(const Level &fine, bool coarsen_x, bool coarsen_y) {
+    Level coarse;
+    coarse.coarsened_x = coarsen_x;
+    coarse.coarsened_y = coarsen_y;
+    coarse.size_x = coarsen_x ? fine.size_x / 2 : fine.size_x;
+    coarse.size_y = coarsen_y ? fine.size_y / 2 : fine.size_y;
+    coarse.dx = coarsen_x ? 2.0 * fine.dx : fine.dx;
+    coarse.dy = coarsen_y ? 2.0 * fine.dy : fine.dy;
+    coarse.iminb = coarsen_x ? fine.iminb / 2 : fine.iminb;
+    coarse.jminb = coarsen_y ? fine.jminb / 2 : fine.jminb;
+
+    int nx = coarse.size_x + 2;
+    int ny = coarse.size_y + 2;
+    coarse.fluid = Matrix<double>(nx, ny, 0.0);
+    coarse.open_x = Matrix<double>(nx, ny, 0.0);
+    coarse.open_y = Matrix<double>(nx, ny, 0.0);
+    for (auto &outflow : coarse.outflow) {
+        outflow = Matrix<double>(nx, ny, 0.0);
+    }
+
+    // A coarse cell is fluid if any of its fine cells is fluid
+    for (int J = 0; J < ny; ++J) {
+        auto range_y = children(J, coarse.size_y, fine.size_y, coarsen_y);
+        for (int I = 0; I < nx; ++I) {
+            auto range_x = children(I, coarse.size_x, fine.size_x, coarsen_x);
+            for (int j = range_y.first; j <= range_y.second; ++j) {
+                for (int i = range_x.first; i <= range_x.second; ++i) {
+                    coarse.fluid(I, J) = std::max(coarse.fluid(I, J), fine.fluid(i, j));
+                }
+            }
+        }
+    }
+    // The ghost layer at subdomain interfaces holds coarse cells of the neighbours
+    Communication::communicate(coarse.fluid);
+
+    // A coarse face is open / outflow by the mean of the fine faces it consists of
+    for (int J = 1; J < ny - 1; ++J) {
+        auto range_y = children(J, coarse.size_y, fine.size_y, coarsen_y);
+        double weight_y = 1.0 / (range_y.second - range_y.first + 1);
+        for (int I = 0; I < nx - 1; ++I) {
+            int i = coarsen_x ? 2 * I : I;
+            for (int j = range_y.first; j <= range_y.second; ++j) {
+                coarse.open_x(I, J) += weight_y * fine.open_x(i, j);
+                if (I > 0) {
+                    coarse.outflow[RIGHT](I, J) += weight_y * fine.outflow[RIGHT](i, j);
+                    coarse.outflow[LEFT](I, J) += weight_y * fine.outflow[LEFT](coarsen_x ? i - 1 : i, j);
+                }
+            }
+        }
+    }
+    for (int J = 0; J < ny - 1; ++J) {
+        int j = coarsen_y ? 2 * J : J;
+        for (int I = 1; I < nx - 1; ++I) {
+            auto range_x = children(I, coarse.size_x, fine.size_x, coarsen_x);
+            double weight_x = 1.0 / (range_x.second - range_x.first + 1);
+            for (int i = range_x.first; i <= range_x.second; ++i) {
+                coarse.open_y(I, J) += weight_x * fine.open_y(i, j);
+                if (J > 0) {
+                    coarse.outflow[UP](I, J) += weight_x * fine.outflow[UP](i, j);
+                    coarse.outflow[DOWN](I, J) += weight_x * fine.outflow[DOWN](i, coarsen_y ? j - 1 : j);
+                }
+            }
+        }
+    }
+
+    finalize_level(coarse);
+    return coarse;
+}
+
+double Multigrid::solve(Fields &field, Grid &, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+
+    cycle(0, field.p_matrix(), field.rs_matrix(), field, boundaries);
+
+    return residual(0, field.p_matrix(), field.rs_matrix());
+}
+
+void Multigrid::cycle(int l, Matrix<double> &P, const Matrix<double> &RS, Fields &field,
+                      const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+
+    if (l == static_cast<int>(_levels.size()) - 1) {
+        smooth(l, P, RS, _coarse_sweeps, _coarse_omega, field, boundaries);
+        return;
+    }
+
+    smooth(l, P, RS, _smoothing_steps, 1.0, field, boundaries);
+
+    residual(l, P, RS);
+    restrict_residual(l);
+
+    Level &coarse = _levels[l + 1];
+    for (int k = 0; k < _cycle_index; ++k) {
+        cycle(l + 1, coarse.p, coarse.rhs, field, boundaries);
+    }
+
+    prolongate_correction(l, P);
+    Communication::communicate(P);
+    if (l == 0) {
+        for (auto &b : boundaries) {
+            b->applyPressure(field);
+        }
+    }
+
+    smooth(l, P, RS, _smoothing_steps, 1.0, field, boundaries);
+}
+
+void Multigrid::smooth(int l, Matrix<double> &P, const Matrix<double> &RS, int sweeps, double omega, Fields &field,
+                       const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    const Level &level = _levels[l];
+    int parity = (level.iminb + level.jminb) % 2;
+
+    for (int s = 0; s < sweeps; ++s) {
+        for (int color = 0; color < 2; ++color) {
+            // The finest level works on the ghost cells of the boundaries, the
+            // coarse levels have the boundary conditions in their operator
+            if (l == 0) {
+                RedBlackSOR::sweep(P, RS, level.mask[color], color + parity, level.dx, level.dy, omega);
+            } else {
+                sweep(level, P, RS, color, omega);
+            }
+            Communication::communicate_color(P, color, parity);
+            if (l == 0) {
+                for (auto &b : boundaries) {
+                    b->applyPressure(field);
+                }
+            }
+        }
+    }
+}
+
+void Multigrid::sweep(const Level &level, Matrix<double> &P, const Matrix<double> &RS, int color, double omega) {
+    double idx2 = 1.0 / (level.dx * level.dx);
+    double idy2 = 1.0 / (level.dy * level.dy);
+
+    int nx = P.num_cols();
+    int ny = P.num_rows();
+    int stride = P.stride();
+    double *p = P.data();
+    const double *rs = RS.data();
+    const double *m = level.mask[color].data();
+    const double *inv_diag = level.inv_diag.data();
+    const double *open_x = level.open_x.data();
+    const double *open_y = level.open_y.data();
+
+    // Only the cells of the color are visited, the cells of the other color
+    // are read by the neighbouring rows
+    int offset = color + (level.iminb + level.jminb) % 2;
+#pragma omp parallel for schedule(static)
+    for (int j = 1; j < ny - 1; ++j) {
+#pragma omp simd
+        for (int i = 1 + (1 + j + offset) % 2; i < nx - 1; i += 2) {
+            int c = j * stride + i;
+            double neighbours = idx2 * (open_x[c - 1] * p[c - 1] + open_x[c] * p[c + 1]) +
+                                idy2 * (open_y[c - stride] * p[c - stride] + open_y[c] * p[c + stride]);
+            double gs = (neighbours - rs[c]) * inv_diag[c];
+            p[c] += m[c] * omega * (gs - p[c]);
+        }
+    }
+}
+
+double Multigrid::residual(int l, const Matrix<double> &P, const Matrix<double> &RS) {
+    Level &level = _levels[l];
+    double idx2 = 1.0 / (level.dx * level.dx);
+    double idy2 = 1.0 / (level.dy * level.dy);
+    // The finest level uses the ghost values set by the boundaries
+    double fine = l == 0 ? 1.0 : 0.0;
+
+    int nx = P.num_cols();
+    int ny = P.num_rows();
+    int stride = P.stride();
+    const double *p = P.data();
+    const double *rs = RS.data();
+    const double *red = level.mask[0].data();
+    const double *black = level.mask[1].data();
+    const double *diag = level.diag.data();
+    const double *open_x = level.open_x.data();
+    const double *open_y = level.open_y.data();
+    double *res = level.res.data();
+
+    double rloc = 0.0;
+#pragma omp parallel for schedule(static) reduction(+ : rloc)
+    for (int j = 1; j < ny - 1; ++j) {
+#pragma omp simd reduction(+ : rloc)
+        for (int i = 1; i < nx - 1; ++i) {
+            int c = j * stride + i;
+            double laplacian =
+                fine * ((p[c + 1] - 2.0 * p[c] + p[c - 1]) * idx2 +
+                        (p[c + stride] - 2.0 * p[c] + p[c - stride]) * idy2) +
+                (1.0 - fine) * (idx2 * (open_x[c - 1] * p[c - 1] + open_x[c] * p[c + 1]) +
+                                idy2 * (open_y[c - stride] * p[c - stride] + open_y[c] * p[c + stride]) -
+                                diag[c] * p[c]);
+            double val = (red[c] + black[c]) * (rs[c] - laplacian);
+            res[c] = val;
+            rloc += val * val;
+        }
+    }
+    return rloc;
+}
+
+void Multigrid::restrict_residual(int l) {
+    const Level &fine = _levels[l];
+    Level &coarse = _levels[l + 1];
+
+    // Volume average of the fine residual, solid fine cells have zero residual
+    double weight = (coarse.coarsened_x ? 0.5 : 1.0) * (coarse.coarsened_y ? 0.5 : 1.0);
+    double sum = 0.0;
+    double count = 0.0;
+    for (int J = 1; J <= coarse.size_y; ++J) {
+        auto range_y = children(J, coarse.size_y, fine.size_y, coarse.coarsened_y);
+        for (int I = 1; I <= coarse.size_x; ++I) {
+            auto range_x = children(I, coarse.size_x, fine.size_x, coarse.coarsened_x);
+            double coupled = coarse.mask[0](I, J) + coarse.mask[1](I, J);
+            double value = 0.0;
+            for (int j = range_y.first; j <= range_y.second; ++j) {
+                for (int i = range_x.first; i <= range_x.second; ++i) {
+                    value += fine.res(i, j);
+                }
+            }
+            coarse.rhs(I, J) = coupled * weight * value;
+            sum += coarse.rhs(I, J);
+            count += coupled;
+        }
+    }
+
+    std::fill(coarse.p.data(), coarse.p.data() + coarse.p.size(), 0.0);
+
+    // Without outflow the coarsest problem is singular, its right hand side
+    // has to be compatible
+    if (_pure_neumann and l + 1 == static_cast<int>(_levels.size()) - 1) {
+        double mean = Communication::reduce_sum(sum) / std::max(Communication::reduce_sum(count), 1.0);
+        for (int J = 1; J <= coarse.size_y; ++J) {
+            for (int I = 1; I <= coarse.size_x; ++I) {
+                coarse.rhs(I, J) -= mean * (coarse.mask[0](I, J) + coarse.mask[1](I, J));
+            }
+        }
+    }
+}
+
+void Multigrid::prolongate_correction(int l, Matrix<double> &P) {
+    const Level &fine = _levels[l];
+    const Level &coarse = _levels[l + 1];
+    const Matrix<double> &E = coarse.p;
+
+    // Bilinear interpolation of the cell-centered correction. Towards a coarse
+    // neighbour the value is blended with the closed (Neumann) and outflow
+    // (Dirichlet) fraction of the face in between.
+    double wx = coarse.coarsened_x ? 0.75 : 1.0;
+    double wy = coarse.coarsened_y ? 0.75 : 1.0;
+
+#pragma omp parallel for schedule(static)
+    for (int j = 1; j <= fine.size_y; ++j) {
+        int J = coarse.coarsened_y ? (j + 1) / 2 : j;
+        int dj = coarse.coarsened_y ? (j % 2 == 1 ? -1 : 1) : 0;
+        for (int i = 1; i <= fine.size_x; ++i) {
+            if (fine.fluid(i, j) == 0.0) {
+                continue;
+            }
+            int I = coarse.coarsened_x ? (i + 1) / 2 : i;
+            int di = coarse.coarsened_x ? (i % 2 == 1 ? -1 : 1) : 0;
+
+            double center = E(I, J);
+            double east = center;
+            double north = center;
+            double corner = center;
+            double open_x = 0.0;
+            double open_y = 0.0;
+            if (di != 0) {
+                open_x = di > 0 ? coarse.open_x(I, J) : coarse.open_x(I - 1, J);
+                double outflow = coarse.outflow[di > 0 ? RIGHT : LEFT](I, J);
+                east = open_x * E(I + di, J) + (1.0 - open_x - 2.0 * outflow) * center;
+            }
+            if (dj != 0) {
+                open_y = dj > 0 ? coarse.open_y(I, J) : coarse.open_y(I, J - 1);
+                double outflow = coarse.outflow[dj > 0 ? UP : DOWN](I, J);
+                north = open_y * E(I, J + dj) + (1.0 - open_y - 2.0 * outflow) * center;
+            }
+            if (di != 0 and dj != 0) {
+                if (open_x == 1.0 and open_y == 1.0 and coarse.fluid(I + di, J + dj) > 0.0) {
+                    corner = E(I + di, J + dj);
+                } else {
+                    corner = east + north - center;
+                }
+            }
+
+            P(i, j) += wx * wy * center + (1.0 - wx) * wy * east + wx * (1.0 - wy) * north +
+                       (1.0 - wx) * (1.0 - wy) * corner;
+        }
+    }
+}
@@ -0,0 +1,169 @@
+#include "PoissonOperator.hpp"
+#include "Communication.hpp"
+
+PoissonOperator::PoissonOperator(const Grid &grid) {
+    _idx2 = 1.0 / (grid.dx() * grid.dx());
+    _idy2 = 1.0 / (grid.dy() * grid.dy());
+    _spans = grid.fluid_spans();
+
+    int nx = grid.size_x() + 2;
+    int ny = grid.size_y() + 2;
+    Matrix<double> outlet(nx, ny, 0.0);
+    _fluid = Matrix<double>(nx, ny, 0.0);
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            cell_type type = grid.cell(i, j).type();
+            _fluid(i, j) = type == cell_type::FLUID ? 1.0 : 0.0;
+            outlet(i, j) = type == cell_type::ZERO_GRADIENT ? 1.0 : 0.0;
+        }
+    }
+
+    // Faces between two fluid cells are open, faces between fluid and outflow
+    // cells carry the Dirichlet condition, all other faces are closed (Neumann)
+    _open_x = Matrix<double>(nx, ny, 0.0);
+    _open_y = Matrix<double>(nx, ny, 0.0);
+    for (auto &outflow : _outflow) {
+        outflow = Matrix<double>(nx, ny, 0.0);
+    }
+    double outflow_faces = 0.0;
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            if (i < nx - 1) {
+                _open_x(i, j) = _fluid(i, j) * _fluid(i + 1, j);
+            }
+            if (j < ny - 1) {
+                _open_y(i, j) = _fluid(i, j) * _fluid(i, j + 1);
+            }
+            if (i == 0 or i == nx - 1 or j == 0 or j == ny - 1) {
+                continue;
+            }
+            _outflow[RIGHT](i, j) = _fluid(i, j) * outlet(i + 1, j);
+            _outflow[LEFT](i, j) = _fluid(i, j) * outlet(i - 1, j);
+            _outflow[UP](i, j) = _fluid(i, j) * outlet(i, j + 1);
+            _outflow[DOWN](i, j) = _fluid(i, j) * outlet(i, j - 1);
+            for (auto &outflow : _outflow) {
+                outflow_faces += outflow(i, j);
+            }
+        }
+    }
+    _singular = Communication::reduce_sum(outflow_faces) == 0.0;
+
+    // Wall corners with fluid on two sides, see FixedWallBoundary::build_tables. The
+    // coupling is idy2 / 2 for the vertical and idx2 / 2 for the horizontal
+    // neighbour, both get the mean to keep the operator symmetric.
+    _corner_weight = 0.25 * (_idx2 + _idy2);
+    Matrix<double> corners(nx, ny, 0.0);
+    auto add_link = [&](int i, int j, int i_nb, int j_nb) {
+        if (i < 1 or i > nx - 2 or j < 1 or j > ny - 2) {
+            return;
+        }
+        _corner_links.push_back({j * corners.stride() + i, j_nb * corners.stride() + i_nb});
+        corners(i, j) += _corner_weight;
+    };
+    // Corners in the halo couple a cell of this process to a halo cell
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            cell_type type = grid.cell(i, j).type();
+            if (type != cell_type::FIXED_WALL and type != cell_type::HOT_WALL and type != cell_type::COLD_WALL) {
+                continue;
+            }
+            bool top = j < ny - 1 and _fluid(i, j + 1) > 0.0;
+            bool bottom = j > 0 and _fluid(i, j - 1) > 0.0;
+            bool left = i > 0 and _fluid(i - 1, j) > 0.0;
+            bool right = i < nx - 1 and _fluid(i + 1, j) > 0.0;
+            for (int k = 0; k < 4; ++k) {
+                bool vertical = k < 2 ? top : bottom;
+                bool horizontal = k % 2 == 0 ? left : right;
+                if (not vertical or not horizontal) {
+                    continue;
+                }
+                int j_v = k < 2 ? j + 1 : j - 1;
+                int i_h = k % 2 == 0 ? i - 1 : i + 1;
+                add_link(i, j_v, i_h, j);
+                add_link(i_h, j, i, j_v);
+            }
+        }
+    }
+
+    _diag = Matrix<double>(nx, ny, 0.0);
+    _inv_diag = Matrix<double>(nx, ny, 0.0);
+    _mask = Matrix<double>(nx, ny, 0.0);
+    double cells = 0.0;
+    for (int j = 1; j < ny - 1; ++j) {
+        for (int i = 1; i < nx - 1; ++i) {
+            double diag = _idx2 * (_open_x(i - 1, j) + _open_x(i, j) +
+                                   2.0 * (_outflow[LEFT](i, j) + _outflow[RIGHT](i, j))) +
+                          _idy2 * (_open_y(i, j - 1) + _open_y(i, j) +
+                                   2.0 * (_outflow[DOWN](i, j) + _outflow[UP](i, j))) +
+                          corners(i, j);
+            if (_fluid(i, j) == 0.0 or diag <= 0.0) {
+                continue;
+            }
+            _diag(i, j) = diag;
+            _inv_diag(i, j) = 1.0 / diag;
+            _mask(i, j) = 1.0;
+            cells += 1.0;
+        }
+    }
+    _global_cells = Communication::reduce_sum(cells);
+}
+
+void PoissonOperator::apply(Matrix<double> &x, Matrix<double> &y) const {
+    Communication::communicate(x);
+
+    int ny = x.num_rows();
+    int stride = x.stride();
+    const double *px = x.data();
+    double *py = y.data();
+    const double *m = _mask.data();
+    const double *diag = _diag.data();
+    const double *open_x = _open_x.data();
+    const double *open_y = _open_y.data();
+    double idx2 = _idx2;
+    double idy2 = _idy2;
+
+#pragma omp parallel for schedule(static)
+    for (int j = 1; j < ny - 1; ++j) {
+        for (const FluidSpan &span : _spans.row(j)) {
+#pragma omp simd
+            for (int i = span.first; i <= span.last; ++i) {
+                int c = j * stride + i;
+                double neighbours = idx2 * (open_x[c - 1] * px[c - 1] + open_x[c] * px[c + 1]) +
+                                    idy2 * (open_y[c - stride] * px[c - stride] + open_y[c] * px[c + stride]);
+                py[c] = m[c] * (diag[c] * px[c] - neighbours);
+            }
+        }
+    }
+
+    for (const auto &link : _corner_links) {
+        py[link.cell] -= _corner_weight * px[link.neighbour];
+    }
+}
+
+double PoissonOperator::local_dot(const Matrix<double> &a, const Matrix<double> &b) const {
+    int n = a.size();
+    const double *pa = a.data();
+    const double *pb = b.data();
+    const double *m = _mask.data();
+
+    double sum = 0.0;
+#pragma omp parallel for simd schedule(static) reduction(+ : sum)
+    for (int c = 0; c < n; ++c) {
+        sum += m[c] * pa[c] * pb[c];
+    }
+    return sum;
+}
+
+const Matrix<double> &PoissonOperator::fluid() const { return _fluid; }
+const Matrix<double> &PoissonOperator::open_x() const { return _open_x; }
+const Matrix<double> &PoissonOperator::open_y() const { return _open_y; }
+const Matrix<double> &PoissonOperator::outflow(DIRECTIONS direction) const { return _outflow[direction]; }
+const Matrix<double> &PoissonOperator::diag() const { return _diag; }
+const Matrix<double> &PoissonOperator::inv_diag() const { return _inv_diag; }
+const Matrix<double> &PoissonOperator::mask() const { return _mask; }
+const std::vector<PoissonOperator::CornerLink> &PoissonOperator::corner_links() const { return _corner_links; }
+double PoissonOperator::corner_weight() const { return _corner_weight; }
+double PoissonOperator::idx2() const { return _idx2; }
+double PoissonOperator::idy2() const { return _idy2; }
+double PoissonOperator::global_cells() const { return _global_cells; }
+bool PoissonOperator::singular() const { return _singular; }
@@ -1,39 +1,231 @@
+#include <algorithm>
 #include <cmath>
 
 #include "Communication.hpp"
 #include "PressureSolver.hpp"
 
-SOR::SOR(double omega) : _omega(omega) {}
+PressureSolver::PressureSolver(const Grid &grid)
+    : _global_cells(Communication::reduce_sum(grid.fluid_cells().size())) {}
+
+double PressureSolver::solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                                    double tolerance, int max_iter, int &iter) {
+    double residual = 1;
+    iter = 0;
+    while (iter < max_iter and residual > tolerance) {
+        double rloc = solve(field, grid, boundaries);
+        iter += 1;
+
+        if (iter % _residual_interval == 0 or iter == max_iter) {
+            residual = std::sqrt(Communication::reduce_sum(rloc) / _global_cells);
+        }
+    }
+    return residual;
+}
+
+void PressureSolver::set_residual_interval(int interval) { _residual_interval = std::max(interval, 1); }
+
+std::string PressureSolver::statistics() const { return ""; }
+
+RelaxationSolver::RelaxationSolver(double omega, const Grid &grid, bool adaptive)
+    : PressureSolver(grid), _omega(omega), _adaptive(adaptive) {}
+
+double RelaxationSolver::solve_system(Fields &field, Grid &grid,
+                                      const std::vector<std::unique_ptr<Boundary>> &boundaries, double tolerance,
+                                      int max_iter, int &iter) {
+    if (not _adaptive) {
+        return PressureSolver::solve_system(field, grid, boundaries, tolerance, max_iter, iter);
+    }
+    adapt();
+
+    // Growth of the residual over its first check, after which the iteration
+    // is taken as diverging
+    constexpr double divergence_factor = 100.0;
+
+    Matrix<double> initial_p = field.p_matrix();
+
+    double residual = 1;
+    bool converged = false;
+    iter = 0;
+    _residual_history.clear();
+    while (iter < max_iter and not converged) {
+        double rloc = solve(field, grid, boundaries);
+        iter += 1;
+
+        if (iter % _residual_interval == 0 or iter == max_iter) {
+            residual = std::sqrt(Communication::reduce_sum(rloc) / _global_cells);
+            converged = residual <= tolerance;
+            _residual_history.emplace_back(iter, residual);
+
+            // restart from the initial pressure with a smaller relaxation factor.
+            // Never on the last check, the pressure and the residual of the
+            // iterations so far are returned instead.
+            bool diverging = not(residual < divergence_factor * _residual_history.front().second);
+            if (not converged and diverging and _omega > 1.0 and iter < max_iter) {
+                _omega_limit = std::max(1.0, 2.0 - 2.0 * (2.0 - _omega));
+                _omega = _omega_limit;
+                field.p_matrix() = initial_p;
+                _residual_history.clear();
+            }
+        }
+    }
+
+    return residual;
+}
+
+std::string RelaxationSolver::statistics() const { return _adaptive ? "\tOmega: " + std::to_string(_omega) : ""; }
+
+void RelaxationSolver::adapt() {
+    // Shorter windows are dominated by the transient of the fast error components
+    constexpr int min_window = 10;
+
+    if (_residual_history.size() < 2) {
+        return;
+    }
+    // The rate is measured over the second half of the iterations, where the
+    // slowest error components dominate
+    const auto &last = _residual_history.back();
+    auto first = std::find_if(_residual_history.begin(), _residual_history.end(),
+                              [&](const std::pair<int, double> &check) { return 2 * check.first >= last.first; });
+    if (first->first == last.first) {
+        first = _residual_history.end() - 2;
+    }
+    int window = last.first - first->first;
+    if (window < min_window or first->second <= 0.0 or last.second <= 0.0) {
+        return;
+    }
+
+    double rho = std::pow(last.second / first->second, 1.0 / window);
+    if (rho >= 1.0) {
+        return;
+    }
+    if (_omega > _previous_omega and 1.0 - rho < 0.9 * (1.0 - _previous_rho)) {
+        // The larger factor converged clearly slower, which Young's relation
+        // misses where the sweep is not consistently ordered near boundaries.
+        // The optimum lies below, so the limit is bisected.
+        _omega_limit = 0.5 * (_omega + _previous_omega);
+        _omega = _previous_omega;
+        return;
+    }
+    _previous_omega = _omega;
+    _previous_rho = rho;
+
+    if (rho <= _omega - 1.0 + 0.1 * (2.0 - _omega)) {
+        // The rate is limited by omega - 1, so omega is at or above the optimum,
+        // where Young's relation does not tell how far. Moving slightly down
+        // lets the next estimate find out.
+        _omega = std::max(1.0, 2.0 - 1.05 * (2.0 - _omega));
+        return;
+    }
+
+    double mu2 = (rho + _omega - 1.0) * (rho + _omega - 1.0) / (rho * _omega * _omega);
+    double optimum = 2.0 / (1.0 + std::sqrt(std::max(1.0 - mu2, 0.0)));
+    // The estimate gets sensitive to the measured rate close to 2, so the
+    // distance to 2 is at most halved per timestep
+    _omega = std::min({optimum, 2.0 - 0.5 * (2.0 - _omega), _omega_limit});
+}
+
+SOR::SOR(double omega, const Grid &grid, bool adaptive) : RelaxationSolver(omega, grid, adaptive) {}
 
 double SOR::solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
 
     double dx = grid.dx();
     double dy = grid.dy();
 
-    double coeff = _omega / (2.0 * (1.0 / (dx * dx) + 1.0 / (dy * dy))); // = _omega * h^2 / 4.0, if dx == dy == h
+    double diag = 2.0 * (1.0 / (dx * dx) + 1.0 / (dy * dy));
+    double coeff = _omega / diag; // = _omega * h^2 / 4.0, if dx == dy == h
 
-    for (auto currentCell : grid.fluid_cells()) {
-        int i = currentCell->i();
-        int j = currentCell->j();
+    // The residual of each cell is taken right before its update, which saves
+    // a second pass over the fluid cells
+    double rloc = 0.0;
+    for (const auto &currentCell : grid.fluid_cells()) {
+        int i = currentCell.i();
+        int j = currentCell.j();
+
+        double helper = Discretization::sor_helper(field.p_matrix(), i, j) - field.rs(i, j);
+        double val = helper - diag * field.p(i, j);
+        rloc += (val * val);
 
-        field.p(i, j) = (1.0 - _omega) * field.p(i, j) +
-                        coeff * (Discretization::sor_helper(field.p_matrix(), i, j) - field.rs(i, j));
+        field.p(i, j) = (1.0 - _omega) * field.p(i, j) + coeff * helper;
     }
 
-    double res = 0.0;
-    double rloc = 0.0;
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    return rloc;
+}
 
-    for (auto currentCell : grid.fluid_cells()) {
-        int i = currentCell->i();
-        int j = currentCell->j();
 
-        double val = Discretization::laplacian(field.p_matrix(), i, j) - field.rs(i, j);
-        rloc += (val * val);
+RedBlackSOR::RedBlackSOR(double omega, const Grid &grid, bool adaptive) : RelaxationSolver(omega, grid, adaptive) {
+    _parity = (grid.domain().iminb + grid.domain().jminb) % 2;
+
+    for (int color = 0; color < 2; ++color) {
+        _mask[color] = Matrix<double>(grid.size_x() + 2, grid.size_y() + 2, 0.0);
     }
-    {
-        res = rloc / (grid.fluid_cells().size());
-        res = std::sqrt(res);
+    for (const auto &currentCell : grid.fluid_cells()) {
+        int i = currentCell.i();
+        int j = currentCell.j();
+        _mask[(i + j + _parity) % 2](i, j) = 1.0;
+    }
+}
+
+double RedBlackSOR::sweep(Matrix<double> &P, const Matrix<double> &RS, const Matrix<double> &mask, int offset,
+                          double dx, double dy, double omega, const FluidSpans *spans) {
+
+    double idx2 = 1.0 / (dx * dx);
+    double idy2 = 1.0 / (dy * dy);
+    double coeff = 1.0 / (2.0 * (idx2 + idy2));
+
+    int nx = P.num_cols();
+    int ny = P.num_rows();
+
+    // Only the cells of the color are visited, every second cell of a row, so
+    // the cells of the other color read by the neighbouring rows are never
+    // written. The mask leaves the non-fluid cells of whole rows unchanged.
+    // The residual of a cell is (gs - p) / coeff before its update.
+    double rloc = 0.0;
+#pragma omp parallel for schedule(static) reduction(+ : rloc)
+    for (int j = 1; j < ny - 1; ++j) {
+        double *p_c = P.row(j);
+        const double *p_s = P.row(j - 1);
+        const double *p_n = P.row(j + 1);
+        const double *rs_c = RS.row(j);
+        const double *m_c = mask.row(j);
+        auto relax = [&](int first, int last) {
+            double sum = 0.0;
+#pragma omp simd reduction(+ : sum)
+            for (int i = first + (first + j + offset) % 2; i <= last; i += 2) {
+                double gs = coeff * ((p_c[i + 1] + p_c[i - 1]) * idx2 + (p_n[i] + p_s[i]) * idy2 - rs_c[i]);
+                double delta = m_c[i] * (gs - p_c[i]);
+                sum += delta * delta;
+                p_c[i] += omega * delta;
+            }
+            return sum;
+        };
+        if (spans == nullptr) {
+            rloc += relax(1, nx - 2);
+            continue;
+        }
+        for (const FluidSpan &span : spans->row(j)) {
+            rloc += relax(span.first, span.last);
+        }
+    }
+    return rloc / (coeff * coeff);
+}
+
+double RedBlackSOR::solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+
+    double rloc = 0.0;
+    for (int color = 0; color < 2; ++color) {
+        rloc += sweep(field.p_matrix(), field.rs_matrix(), _mask[color], color + _parity, grid.dx(), grid.dy(),
+                      _omega, &grid.fluid_spans());
+
+        Communication::communicate_color(field.p_matrix(), color, _parity);
+        for (auto &b : boundaries) {
+            b->applyPressure(field);
+        }
     }
 
-    return res;
+    return rloc;
 }
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "Communication.hpp"
+#include "Schwarz.hpp"
+
+namespace {
+/// Boxes per direction of the subdomain whose coupled cells form the aggregates of the coarse space
+constexpr int aggregate_boxes = 4;
+} // namespace
+
+AdditiveSchwarz::AdditiveSchwarz(const PoissonOperator &op, const Grid &grid) {
+    int nx = grid.size_x() + 2;
+    int ny = grid.size_y() + 2;
+    double idx2 = op.idx2();
+    double idy2 = op.idy2();
+    const Matrix<double> &fluid = op.fluid();
+    int stride = fluid.stride();
+    std::array<int, 4> neighbours = Communication::get_neighbours();
+
+    int rank;
+    MPI_Comm_rank(MPI_COMMUNICATOR, &rank);
+
+    auto inner = [&](int i, int j) { return i >= 1 and i <= nx - 2 and j >= 1 and j <= ny - 2; };
+    // Fluid cells of the ghost layer at process interfaces, without its corners
+    auto overlap = [&](int i, int j) {
+        if (fluid(i, j) == 0.0) {
+            return false;
+        }
+        bool rows = j >= 1 and j <= ny - 2;
+        bool cols = i >= 1 and i <= nx - 2;
+        return (rows and i == 0 and neighbours[LEFT] != MPI_PROC_NULL) or
+               (rows and i == nx - 1 and neighbours[RIGHT] != MPI_PROC_NULL) or
+               (cols and j == 0 and neighbours[DOWN] != MPI_PROC_NULL) or
+               (cols and j == ny - 1 and neighbours[UP] != MPI_PROC_NULL);
+    };
+
+    // Unknowns are numbered along the shorter direction to keep the bandwidth small
+    std::vector<int> index(fluid.size(), -1);
+    auto number = [&](int i, int j) {
+        if ((inner(i, j) and op.mask()(i, j) > 0.0) or overlap(i, j)) {
+            index[j * stride + i] = _cells.size();
+            _cells.push_back(j * stride + i);
+        }
+    };
+    if (nx <= ny) {
+        for (int j = 0; j < ny; ++j) {
+            for (int i = 0; i < nx; ++i) {
+                number(i, j);
+            }
+        }
+    } else {
+        for (int i = 0; i < nx; ++i) {
+            for (int j = 0; j < ny; ++j) {
+                number(i, j);
+            }
+        }
+    }
+    int n = _cells.size();
+
+    // Couplings (row, column, value) of the lower triangle and the diagonal
+    std::vector<double> diag(n, 0.0);
+    std::vector<std::pair<std::pair<int, int>, double>> couplings;
+    auto couple = [&](int a, int b, double value) {
+        couplings.push_back({{std::max(a, b), std::min(a, b)}, value});
+    };
+    for (int k = 0; k < n; ++k) {
+        int i = _cells[k] % stride;
+        int j = _cells[k] / stride;
+        if (inner(i, j)) {
+            diag[k] = op.diag()(i, j);
+        } else {
+            // faces beyond the ghost layer are taken as open with zero values
+            const std::array<std::pair<int, int>, 4> faces{{{i - 1, j}, {i + 1, j}, {i, j - 1}, {i, j + 1}}};
+            for (const auto &face : faces) {
+                bool outside = face.first < 0 or face.first >= nx or face.second < 0 or face.second >= ny;
+                if (outside or fluid(face.first, face.second) > 0.0) {
+                    diag[k] += face.first != i ? idx2 : idy2;
+                }
+            }
+        }
+        if (i + 1 < nx and index[_cells[k] + 1] >= 0) {
+            couple(k, index[_cells[k] + 1], -idx2);
+        }
+        if (j + 1 < ny and index[_cells[k] + stride] >= 0) {
+            couple(k, index[_cells[k] + stride], -idy2);
+        }
+    }
+    // Links among inner cells are listed in both directions, links to the
+    // ghost layer only from the inner cell
+    for (const auto &link : op.corner_links()) {
+        int a = index[link.cell];
+        int b = index[link.neighbour];
+        if (a < 0 or b < 0) {
+            continue;
+        }
+        if (inner(link.neighbour % stride, link.neighbour / stride)) {
+            if (b < a) {
+                couple(a, b, -op.corner_weight());
+            }
+        } else {
+            couple(a, b, -op.corner_weight());
+            diag[b] += op.corner_weight();
+        }
+    }
+
+    int bandwidth = 0;
+    for (const auto &coupling : couplings) {
+        bandwidth = std::max(bandwidth, coupling.first.first - coupling.first.second);
+    }
+    _local = BandedCholesky(n, bandwidth);
+    for (int k = 0; k < n; ++k) {
+        _local.add(k, k, diag[k]);
+    }
+    for (const auto &coupling : couplings) {
+        _local.add(coupling.first.first, coupling.first.second, coupling.second);
+    }
+    // A subdomain without outflow, e.g. the whole domain on a single process, is singular
+    _local.pin_singular_components();
+    _local.factorize();
+
+    // Aggregates of the coarse space, the coupled cells in each of the boxes of the subdomain
+    int size_x = nx - 2;
+    int size_y = ny - 2;
+    std::vector<int> box_aggregate(aggregate_boxes * aggregate_boxes, -1);
+    _aggregate.assign(fluid.size(), -1);
+    for (int j = 1; j < ny - 1; ++j) {
+        for (int i = 1; i < nx - 1; ++i) {
+            if (op.mask()(i, j) == 0.0) {
+                continue;
+            }
+            int box = (j - 1) * aggregate_boxes / size_y * aggregate_boxes + (i - 1) * aggregate_boxes / size_x;
+            if (box_aggregate[box] < 0) {
+                box_aggregate[box] = _num_aggregates++;
+            }
+            _aggregate[j * stride + i] = box_aggregate[box];
+        }
+    }
+    _coarse_counts = Communication::all_gather(_num_aggregates);
+    for (int p = 0; p < rank; ++p) {
+        _offset += _coarse_counts[p];
+    }
+
+    // Global numbers of the aggregates of this process and, after the exchange, of the halo cells
+    Matrix<double> ids(nx, ny, -1.0);
+    for (int c = 0; c < fluid.size(); ++c) {
+        if (_aggregate[c] >= 0) {
+            ids.data()[c] = _offset + _aggregate[c];
+        }
+    }
+    Communication::communicate(ids);
+
+    // Rows of the aggregates of this process in the Galerkin operator A0 = P^T A P,
+    // P the piecewise constant interpolation from the aggregates
+    std::map<std::pair<int, int>, double> rows;
+    auto add_coupling = [&](int row, int neighbour, double value) {
+        int col = static_cast<int>(ids.data()[neighbour]);
+        if (col >= 0) {
+            rows[{row, col}] -= value;
+        }
+    };
+    for (int j = 1; j < ny - 1; ++j) {
+        for (int i = 1; i < nx - 1; ++i) {
+            int c = j * stride + i;
+            if (_aggregate[c] < 0) {
+                continue;
+            }
+            int row = _offset + _aggregate[c];
+            rows[{row, row}] += op.diag()(i, j);
+            add_coupling(row, c - 1, idx2 * op.open_x()(i - 1, j));
+            add_coupling(row, c + 1, idx2 * op.open_x()(i, j));
+            add_coupling(row, c - stride, idy2 * op.open_y()(i, j - 1));
+            add_coupling(row, c + stride, idy2 * op.open_y()(i, j));
+        }
+    }
+    for (const auto &link : op.corner_links()) {
+        add_coupling(_offset + _aggregate[link.cell], link.neighbour, op.corner_weight());
+    }
+
+    // The lower triangle of all rows is gathered on every process, whose
+    // numbering follows the process grid, so the band is a few rows of processes wide
+    std::vector<double> entries;
+    for (const auto &entry : rows) {
+        if (entry.first.second <= entry.first.first) {
+            entries.insert(entries.end(), {static_cast<double>(entry.first.first),
+                                           static_cast<double>(entry.first.second), entry.second});
+        }
+    }
+    std::vector<double> all_entries;
+    Communication::all_gather(entries, Communication::all_gather(static_cast<int>(entries.size())), all_entries);
+    int coarse_size = 0;
+    for (int count : _coarse_counts) {
+        coarse_size += count;
+    }
+    int coarse_bandwidth = 0;
+    for (std::size_t e = 0; e < all_entries.size(); e += 3) {
+        coarse_bandwidth = std::max(coarse_bandwidth, static_cast<int>(all_entries[e] - all_entries[e + 1]));
+    }
+
+    // Without outflow the coarse operator is singular, one coarse unknown per
+    // region is pinned and the mean of the coarse right hand side removed
+    _coarse = BandedCholesky(coarse_size, coarse_bandwidth);
+    for (std::size_t e = 0; e < all_entries.size(); e += 3) {
+        _coarse.add(static_cast<int>(all_entries[e]), static_cast<int>(all_entries[e + 1]), all_entries[e + 2]);
+    }
+    _coarse.pin_singular_components();
+    _coarse.factorize();
+
+    _r_ext = Matrix<double>(nx, ny, 0.0);
+    _x.resize(n);
+    _coarse_r.resize(_num_aggregates);
+}
+
+void AdditiveSchwarz::apply(const Matrix<double> &r, Matrix<double> &z) {
+    // Local problems with the residual of the neighbours in the overlap
+    std::copy(r.data(), r.data() + r.size(), _r_ext.data());
+    Communication::communicate(_r_ext);
+    for (std::size_t k = 0; k < _cells.size(); ++k) {
+        _x[k] = _r_ext.data()[_cells[k]];
+    }
+    _local.solve(_x);
+    std::fill(z.data(), z.data() + z.size(), 0.0);
+    for (std::size_t k = 0; k < _cells.size(); ++k) {
+        z.data()[_cells[k]] = _x[k];
+    }
+    Communication::accumulate(z);
+
+    // Coarse problem with the sums of the residual over the aggregates
+    const double *r_data = r.data();
+    std::fill(_coarse_r.begin(), _coarse_r.end(), 0.0);
+    for (int c = 0; c < r.size(); ++c) {
+        if (_aggregate[c] >= 0) {
+            _coarse_r[_aggregate[c]] += r_data[c];
+        }
+    }
+    Communication::all_gather(_coarse_r, _coarse_counts, _coarse_x);
+    _coarse.solve(_coarse_x);
+
+    double *z_data = z.data();
+    for (int c = 0; c < z.size(); ++c) {
+        z_data[c] = _aggregate[c] < 0 ? 0.0 : z_data[c] + _coarse_x[_offset + _aggregate[c]];
+    }
+}
@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <cmath>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "Communication.hpp"
+#include "PoissonOperator.hpp"
+#include "TiledSOR.hpp"
+
+TiledSOR::TiledSOR(double omega, const Grid &grid, int sweeps)
+    : PressureSolver(grid), _omega(omega), _sweeps(std::max(sweeps, 1)) {
+    PoissonOperator op(grid);
+    _idx2 = op.idx2();
+    _idy2 = op.idy2();
+    _parity = (grid.domain().iminb + grid.domain().jminb) % 2;
+    _spans = grid.fluid_spans();
+
+    int nx = grid.size_x() + 2;
+    int ny = grid.size_y() + 2;
+    _inv_diag = Matrix<double>(nx, ny, 0.0);
+    for (const auto &currentCell : grid.fluid_cells()) {
+        _inv_diag(currentCell.i(), currentCell.j()) = op.inv_diag()(currentCell.i(), currentCell.j());
+    }
+
+    // Cells with corner links are taken out of the vectorized row pass and
+    // relaxed with their links right after it. Both cells of a link have the
+    // same color and are at most one row apart.
+    _corner_weight = op.corner_weight();
+    int stride = op.mask().stride();
+    for (const auto &link : op.corner_links()) {
+        auto cell = std::find_if(_linked.begin(), _linked.end(),
+                                 [&](const LinkedCell &candidate) { return candidate.cell == link.cell; });
+        if (cell == _linked.end()) {
+            _linked.push_back({link.cell, op.inv_diag().data()[link.cell], {}});
+            cell = _linked.end() - 1;
+        }
+        cell->neighbours.push_back(link.neighbour);
+        _inv_diag.data()[link.cell] = 0.0;
+    }
+    std::sort(_linked.begin(), _linked.end(),
+              [](const LinkedCell &a, const LinkedCell &b) { return a.cell < b.cell; });
+    _linked_start.assign(ny + 1, 0);
+    for (const auto &cell : _linked) {
+        _linked_start[cell.cell / stride + 1] += 1;
+    }
+    for (int j = 0; j < ny; ++j) {
+        _linked_start[j + 1] += _linked_start[j];
+    }
+
+    _r = Matrix<double>(nx, ny, 0.0);
+    _e = Matrix<double>(nx, ny, 0.0);
+}
+
+double TiledSOR::solve(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    double rloc = residual(field, grid);
+    relax(_sweeps);
+    update(field, boundaries);
+    return rloc;
+}
+
+double TiledSOR::solve_system(Fields &field, Grid &grid, const std::vector<std::unique_ptr<Boundary>> &boundaries,
+                              double tolerance, int max_iter, int &iter) {
+    // the pressure may have been replaced by an extrapolated guess
+    Communication::communicate(field.p_matrix());
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+
+    iter = 0;
+    double res = std::sqrt(Communication::reduce_sum(residual(field, grid)) / _global_cells);
+    while (res > tolerance and iter < max_iter) {
+        int sweeps = std::min(_sweeps, max_iter - iter);
+        relax(sweeps);
+        update(field, boundaries);
+        iter += sweeps;
+        res = std::sqrt(Communication::reduce_sum(residual(field, grid)) / _global_cells);
+    }
+    return res;
+}
+
+double TiledSOR::residual(Fields &field, const Grid &grid) {
+    const Matrix<double> &P = field.p_matrix();
+    const Matrix<double> &RS = field.rs_matrix();
+    const FluidSpans &spans = grid.fluid_spans();
+    int ny = P.num_rows();
+    double idx2 = _idx2;
+    double idy2 = _idy2;
+
+    double rloc = 0.0;
+#pragma omp parallel for schedule(static) reduction(+ : rloc)
+    for (int j = 1; j < ny - 1; ++j) {
+        const double *p_c = P.row(j);
+        const double *p_s = P.row(j - 1);
+        const double *p_n = P.row(j + 1);
+        const double *rs_c = RS.row(j);
+        double *r_c = _r.row(j);
+        double *e_c = _e.row(j);
+        for (const FluidSpan &span : spans.row(j)) {
+#pragma omp simd reduction(+ : rloc)
+            for (int i = span.first; i <= span.last; ++i) {
+                double val = (p_c[i + 1] - 2.0 * p_c[i] + p_c[i - 1]) * idx2 +
+                             (p_n[i] - 2.0 * p_c[i] + p_s[i]) * idy2 - rs_c[i];
+                r_c[i] = val;
+                e_c[i] = 0.0;
+                rloc += val * val;
+            }
+        }
+    }
+    return rloc;
+}
+
+void TiledSOR::relax(int sweeps) {
+    int rows = _e.num_rows() - 2;
+    int levels = 2 * sweeps;
+    // The triangles left at the strip edges reach levels - 1 rows into both
+    // strips, they must not touch the ones of the next edge
+    int min_height = 2 * levels + 2;
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    int strips = std::max(1, std::min(threads, rows / min_height));
+
+    // Rows [first, last] of half-sweep h in the trapezoid of strip s
+    auto first_row = [&](int s, int h) { return s == 0 ? 1 : 1 + s * rows / strips + 1 + h; };
+    auto last_row = [&](int s, int h) { return s == strips - 1 ? rows : (s + 1) * rows / strips - h; };
+
+#pragma omp parallel
+    {
+#pragma omp for schedule(static)
+        for (int s = 0; s < strips; ++s) {
+            // Half-sweep h relaxes row t - h in step t, after the rows around it
+            // got half-sweep h - 1 and before they get half-sweep h + 1
+            for (int t = first_row(s, 0); t <= last_row(s, 0) + levels - 1; ++t) {
+                for (int h = 0; h < levels; ++h) {
+                    int j = t - h;
+                    if (j >= first_row(s, h) and j <= last_row(s, h)) {
+                        relax_row(j, h % 2);
+                    }
+                }
+            }
+        }
+#pragma omp for schedule(static)
+        for (int s = 1; s < strips; ++s) {
+            // Triangle of the rows between the trapezoids of strips s - 1 and s
+            int edge = 1 + s * rows / strips;
+            for (int h = 0; h < levels; ++h) {
+                for (int j = edge - h; j <= edge + h; ++j) {
+                    relax_row(j, h % 2);
+                }
+            }
+        }
+    }
+}
+
+void TiledSOR::relax_row(int j, int color) {
+    int stride = _e.stride();
+    double idx2 = _idx2;
+    double idy2 = _idy2;
+    double omega = _omega;
+    double *e = _e.data();
+    const double *r = _r.data();
+
+    double *e_c = _e.row(j);
+    const double *e_s = _e.row(j - 1);
+    const double *e_n = _e.row(j + 1);
+    const double *r_c = _r.row(j);
+    const double *d_c = _inv_diag.row(j);
+    // cells with (i + offset) even have the color and only those are visited,
+    // the linked cells have a zero inverse diagonal here and are left unchanged
+    int offset = j + _parity + color;
+    for (const FluidSpan &span : _spans.row(j)) {
+#pragma omp simd
+        for (int i = span.first + (span.first + offset) % 2; i <= span.last; i += 2) {
+            double sum = (e_c[i + 1] + e_c[i - 1]) * idx2 + (e_n[i] + e_s[i]) * idy2 + r_c[i];
+            double delta = d_c[i] > 0.0 ? d_c[i] * sum - e_c[i] : 0.0;
+            e_c[i] += omega * delta;
+        }
+    }
+
+    for (int l = _linked_start[j]; l < _linked_start[j + 1]; ++l) {
+        const LinkedCell &cell = _linked[l];
+        int c = cell.cell;
+        if ((c - j * stride + offset) % 2 != 0) {
+            continue;
+        }
+        double sum = (e[c + 1] + e[c - 1]) * idx2 + (e[c + stride] + e[c - stride]) * idy2 + r[c];
+        for (int neighbour : cell.neighbours) {
+            sum += _corner_weight * e[neighbour];
+        }
+        e[c] += omega * (cell.inv_diag * sum - e[c]);
+    }
+}
+
+void TiledSOR::update(Fields &field, const std::vector<std::unique_ptr<Boundary>> &boundaries) {
+    Matrix<double> &P = field.p_matrix();
+    int ny = P.num_rows();
+
+#pragma omp parallel for schedule(static)
+    for (int j = 1; j < ny - 1; ++j) {
+        double *p_c = P.row(j);
+        const double *e_c = _e.row(j);
+        for (const FluidSpan &span : _spans.row(j)) {
+#pragma omp simd
+            for (int i = span.first; i <= span.last; ++i) {
+                p_c[i] += e_c[i];
+            }
+        }
+    }
+
+    Communication::communicate(P);
+    for (auto &b : boundaries) {
+        b->applyPressure(field);
+    }
+}